@@ -1,3 +1,11 @@
+// define FREEMANAPI_THREAD_CONTEXTS to give every thread its own player, settings and callbacks
+// used by the headless tools to simulate many players at once, the dll keeps plain globals
+#ifdef FREEMANAPI_THREAD_CONTEXTS
+#define FREEMANAPI_THREAD_LOCAL thread_local
+#else
+#define FREEMANAPI_THREAD_LOCAL
+#endif
+
 // custom config
 namespace FreemanAPI {
 #ifdef FREEMANAPI_FOUC_MENULIB
@@ -77,31 +85,31 @@ namespace FreemanAPI {
 		}
 #endif
 	};
-	std::vector<tConfigValue> aBehaviorConfig;
-	std::vector<tConfigValue> aCVarConfigHL1;
-	std::vector<tConfigValue> aCVarConfigHL2;
-	std::vector<tConfigValue> aAdvancedConfig;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aBehaviorConfig;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aCVarConfigHL1;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aCVarConfigHL2;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aAdvancedConfig;
 
 	// ingame variable config
-	bool bEnabled = true;
-	bool bCanLongJump = false;
-	bool bAutoHop = true;
-	bool bABH = false;
-	bool bABHMixed = false;
-	bool bBhopCap = false;
-	bool bSmartVelocityCap = false;
-	bool bNoclipKey = false;
-	bool bHL2Mode = true;
+	FREEMANAPI_THREAD_LOCAL bool bEnabled = true;
+	FREEMANAPI_THREAD_LOCAL bool bCanLongJump = false;
+	FREEMANAPI_THREAD_LOCAL bool bAutoHop = true;
+	FREEMANAPI_THREAD_LOCAL bool bABH = false;
+	FREEMANAPI_THREAD_LOCAL bool bABHMixed = false;
+	FREEMANAPI_THREAD_LOCAL bool bBhopCap = false;
+	FREEMANAPI_THREAD_LOCAL bool bSmartVelocityCap = false;
+	FREEMANAPI_THREAD_LOCAL bool bNoclipKey = false;
+	FREEMANAPI_THREAD_LOCAL bool bHL2Mode = true;
 
 	// game integration config
-	bool bConvertUnits = true; // do conversions from units to meters when handling game funcs
+	FREEMANAPI_THREAD_LOCAL bool bConvertUnits = true; // do conversions from units to meters when handling game funcs
 
 	// rotation order
-	int PITCH = 1;
-	int YAW = 0;
-	int ROLL = 2;
+	FREEMANAPI_THREAD_LOCAL int PITCH = 1;
+	FREEMANAPI_THREAD_LOCAL int YAW = 0;
+	FREEMANAPI_THREAD_LOCAL int ROLL = 2;
 
 	// 2 & 1 for Y-up, 1 & 2 for Z-up
-	int FORWARD = 2;
-	int UP = 1;
+	FREEMANAPI_THREAD_LOCAL int FORWARD = 2;
+	FREEMANAPI_THREAD_LOCAL int UP = 1;
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+// player contexts and the lag compensation hull history
+// a context is one simulated player, switching contexts just points pmove at another player
+// settings and callbacks stay shared, so a server can run every client through the same library instance
+namespace FreemanAPI {
+	struct tHullSample {
+		double time;
+		NyaVec3Double origin;
+		int hull;
+		bool ducked;
+	};
+
+	// fixed capacity ring of where the hull was at the end of every substep, oldest samples get overwritten
+	struct tHullHistory {
+		std::vector<tHullSample> samples;
+		uint32_t head = 0; // total samples written
+		uint32_t count = 0;
+
+		void Clear() {
+			head = 0;
+			count = 0;
+		}
+
+		void SetCapacity(int capacity) {
+			samples.clear();
+			samples.resize(std::max(capacity, 0));
+			samples.shrink_to_fit();
+			Clear();
+		}
+
+		const tHullSample& Get(uint32_t index) const {
+			return samples[(head - count + index) % samples.size()];
+		}
+
+		void Add(const tHullSample& sample) {
+			if (samples.empty()) return;
+
+			// rolled back and re-simulated, the newer samples are stale now
+			while (count && Get(count - 1).time >= sample.time) {
+				head--;
+				count--;
+			}
+
+			samples[head % samples.size()] = sample;
+			head++;
+			if (count < samples.size()) count++;
+		}
+
+		// false if the time is older than anything still in the history, times past the newest sample are clamped
+		bool GetAtTime(double time, tHullSample& out) const {
+			if (!count) return false;
+			if (time < Get(0).time) return false;
+
+			auto& newest = Get(count - 1);
+			if (time >= newest.time) {
+				out = newest;
+				return true;
+			}
+
+			// samples are in time order, find the first one after the requested time
+			uint32_t low = 1;
+			uint32_t high = count - 1;
+			while (low < high) {
+				auto mid = (low + high) / 2;
+				if (Get(mid).time <= time) low = mid + 1;
+				else high = mid;
+			}
+
+			auto& a = Get(low - 1);
+			auto& b = Get(low);
+			double t = (time - a.time) / (b.time - a.time);
+			out = t < 0.5 ? a : b; // hull changes snap to the nearest substep
+			out.time = time;
+			out.origin = a.origin + (b.origin - a.origin) * t;
+			return true;
+		}
+	};
+
+	FREEMANAPI_THREAD_LOCAL int nHullHistoryLength = 256; // samples per context, 4 physics steps at 60fps keeps about a second
+
+	// the frame budget's collision quality, per context like the stats since each player's frames cost differently
+	FREEMANAPI_THREAD_LOCAL int nBudgetQualityLevel = 0;
+	FREEMANAPI_THREAD_LOCAL int nBudgetCalmFrames = 0;
+
+	const int MAX_TOUCHES = 32;
+
+	struct tTouch {
+		int ent;
+		int surfaceId;
+		NyaVec3Double normal;
+		NyaVec3Double velocity;
+	};
+
+	// what the player hit during the last frame, one entry per entity and plane, cleared when the next frame starts
+	struct tTouchBuffer {
+		tTouch touches[MAX_TOUCHES];
+		int count = 0;
+	};
+
+	const int MAX_INPUT_EVENTS = 1024;
+
+	// timestamped input from the host, Process hands each substep the events inside its slice of the frame
+	struct tInputEvents {
+		std::vector<FreemanInputEvent> queue; // in time order
+		FreemanInputFrame state = {}; // the input as of the last event applied, carried over between frames
+		uint32_t mask = 0; // 1 << INPUT_EVENT_ for every type the host has sent, those aren't polled anymore
+	};
+
+	// eye position and angles with the view only effect, the bob, on top
+	// worked out from the physics state when the host asks for them, at most once per frame, see CalcView
+	struct tViewState {
+		NyaVec3Double origin = {0,0,0}; // movement units
+		NyaVec3Double angles = {0,0,0};
+		double simTime = 0; // flSimTime the effects were last advanced to
+		double bobTime = 0;
+		float bob = 0;
+		bool bDirty = true; // the physics ran since, origin and angles are stale
+	};
+
+	struct tPlayerContext {
+		playermove_s* move;
+		tHullHistory history;
+		tTouchBuffer touches;
+		tInputEvents inputEvents;
+		tViewState view;
+		FreemanStats stats; // kept here while another context is current, SetContext swaps them in and out of the global
+		int budgetQualityLevel = 0; // same for the frame budget state
+		int budgetCalmFrames = 0;
+	};
+
+	FREEMANAPI_THREAD_LOCAL std::vector<tPlayerContext*> aContexts; // null for destroyed ids
+	FREEMANAPI_THREAD_LOCAL tPlayerContext* pContext = nullptr;
+
+	// frees the contexts when the thread that made them exits, context 0's player is pmoveStorage and isn't ours to delete
+	struct tContextCleanup {
+		~tContextCleanup() {
+			for (int i = 0; i < (int)aContexts.size(); i++) {
+				if (!aContexts[i]) continue;
+				if (i) delete aContexts[i]->move;
+				delete aContexts[i];
+			}
+			aContexts.clear();
+			pContext = nullptr;
+		}
+	};
+
+	// context 0 is the player everything starts with
+	tPlayerContext* GetContext() {
+		if (pContext) return pContext;
+
+		auto context = new tPlayerContext;
+		context->move = &pmoveStorage;
+		context->history.SetCapacity(nHullHistoryLength);
+		aContexts.push_back(context);
+		pContext = context;
+
+		// constructed after aContexts so it's destroyed before it
+		static FREEMANAPI_THREAD_LOCAL tContextCleanup cleanup;
+		return pContext;
+	}
+
+	int CreateContext() {
+		GetContext();
+
+		auto context = new tPlayerContext;
+		context->move = new playermove_s(); // zeroed like context 0's, Reset doesn't set everything
+		context->history.SetCapacity(nHullHistoryLength);
+		for (int i = 1; i < (int)aContexts.size(); i++) {
+			if (!aContexts[i]) {
+				aContexts[i] = context;
+				return i;
+			}
+		}
+		aContexts.push_back(context);
+		return aContexts.size() - 1;
+	}
+
+	bool SetContext(int id) {
+		GetContext();
+		if (id < 0 || id >= (int)aContexts.size() || !aContexts[id]) return false;
+
+		// the hot path keeps counting into the globals, every context gets its own counters and budget state by swapping them here
+		if (aContexts[id] != pContext) {
+			pContext->stats = stats;
+			pContext->budgetQualityLevel = nBudgetQualityLevel;
+			pContext->budgetCalmFrames = nBudgetCalmFrames;
+			stats = aContexts[id]->stats;
+			nBudgetQualityLevel = aContexts[id]->budgetQualityLevel;
+			nBudgetCalmFrames = aContexts[id]->budgetCalmFrames;
+		}
+		pContext = aContexts[id];
+		pmove = pContext->move;
+		return true;
+	}
+
+	int GetContextID() {
+		auto context = GetContext();
+		for (int i = 0; i < (int)aContexts.size(); i++) {
+			if (aContexts[i] == context) return i;
+		}
+		return 0;
+	}
+
+	void DestroyContext(int id) {
+		GetContext();
+		if (id <= 0 || id >= (int)aContexts.size() || !aContexts[id]) return;
+		if (aContexts[id] == pContext) SetContext(0);
+		delete aContexts[id]->move;
+		delete aContexts[id];
+		aContexts[id] = nullptr;
+	}
+
+	void SetHullHistoryLength(int length) {
+		nHullHistoryLength = std::max(length, 0);
+		GetContext();
+		for (auto& context : aContexts) {
+			if (context) context->history.SetCapacity(nHullHistoryLength);
+		}
+	}
+
+	void RecordHullHistory(int hull) {
+		tHullSample sample;
+		sample.time = pmove->flSimTime;
+		sample.origin = pmove->origin;
+		sample.hull = hull;
+		sample.ducked = (pmove->flags & FL_DUCKING) != 0;
+		GetContext()->history.Add(sample);
+	}
+
+	// the hull in the same space the game callbacks use, origin is the center like SetGamePlayerPosition
+	void GetHullSampleForGame(const playermove_s* move, const tHullSample& sample, FreemanHullSample* out) {
+		auto mins = move->player_mins[sample.hull];
+		auto maxs = move->player_maxs[sample.hull];
+		auto center = (mins[UP] + maxs[UP]) * 0.5;
+		mins[UP] -= center;
+		maxs[UP] -= center;
+		auto origin = sample.origin;
+		origin[UP] += center;
+
+		if (bConvertUnits) {
+			for (int i = 0; i < 3; i++) {
+				origin[i] = UnitsToMeters(origin[i]);
+				mins[i] = UnitsToMeters(mins[i]);
+				maxs[i] = UnitsToMeters(maxs[i]);
+			}
+			origin *= vXYZUnitsMult;
+			mins *= vXYZUnitsMult;
+			maxs *= vXYZUnitsMult;
+		}
+
+		out->time = sample.time;
+		for (int i = 0; i < 3; i++) {
+			out->origin[i] = origin[i];
+			out->mins[i] = std::min(mins[i], maxs[i]); // a flipped axis swaps them
+			out->maxs[i] = std::max(mins[i], maxs[i]);
+		}
+		out->hull = sample.hull;
+		out->ducked = sample.ducked;
+		out->valid = true;
+	}
+
+	bool GetHullAtTime(double time, FreemanHullSample* out) {
+		tHullSample sample;
+		auto context = GetContext();
+		if (!context->history.GetAtTime(time, sample)) {
+			out->valid = false;
+			return false;
+		}
+		GetHullSampleForGame(context->move, sample, out);
+		return true;
+	}
+
+	// fills out[id] for every context id below maxContexts, returns the number of context ids
+	int RewindAllContexts(double time, FreemanHullSample* out, int maxContexts) {
+		GetContext();
+		for (int i = 0; i < (int)aContexts.size() && i < maxContexts; i++) {
+			tHullSample sample;
+			auto context = aContexts[i];
+			if (!context || !context->history.GetAtTime(time, sample)) {
+				out[i].valid = false;
+				continue;
+			}
+			GetHullSampleForGame(context->move, sample, &out[i]);
+		}
+		return aContexts.size();
+	}
+
+	// copies up to maxTouches of the last frame's touches, returns how many there were
+	int GetTouches(FreemanTouch* out, int maxTouches) {
+		auto& buffer = GetContext()->touches;
+		for (int i = 0; i < buffer.count && i < maxTouches; i++) {
+			auto& touch = buffer.touches[i];
+			auto normal = touch.normal;
+			auto velocity = touch.velocity;
+			if (bConvertUnits) {
+				for (int j = 0; j < 3; j++) {
+					velocity[j] = UnitsToMeters(velocity[j]);
+				}
+				normal *= vXYZUnitsMult;
+				velocity *= vXYZUnitsMult;
+			}
+
+			out[i].ent = touch.ent;
+			out[i].surfaceId = touch.surfaceId;
+			for (int j = 0; j < 3; j++) {
+				out[i].normal[j] = normal[j];
+				out[i].velocity[j] = velocity[j];
+			}
+		}
+		return buffer.count;
+	}
+
+	// false if the type is unknown, the time isn't a number or the queue is full, events with the same time keep the order they came in
+	bool QueueInputEvent(const FreemanInputEvent& event) {
+		if (event.type < 0 || event.type >= NUM_INPUT_EVENTS || !std::isfinite(event.time)) return false;
+
+		auto& events = GetContext()->inputEvents;
+		if (events.queue.size() >= MAX_INPUT_EVENTS) return false;
+
+		auto it = events.queue.end();
+		while (it != events.queue.begin() && (it - 1)->time > event.time) it--;
+		events.queue.insert(it, event);
+		events.mask |= 1 << event.type;
+		return true;
+	}
+
+	// drops anything still queued and goes back to polling the input callbacks
+	void ClearInputEvents() {
+		auto& events = GetContext()->inputEvents;
+		events.queue.clear();
+		events.state = {};
+		events.mask = 0;
+	}
+}
\ No newline at end of file
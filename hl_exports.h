@@ -1,67 +1,109 @@
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_PlayGameSound(void(*func)(const char*, float)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_PlayGameSound = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGamePlayerDead(bool(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGamePlayerDead = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGamePlayerPosition(void(*func)(double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGamePlayerPosition = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGamePlayerVelocity(void(*func)(double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGamePlayerVelocity = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGamePlayerViewAngle(void(*func)(double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGamePlayerViewAngle = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_SetGamePlayerPosition(void(*func)(const double*, const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_SetGamePlayerPosition = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_SetGamePlayerPositionRaw(void(*func)(const double*, const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_SetGamePlayerPositionRaw = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_SetGamePlayerViewPosition(void(*func)(const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_SetGamePlayerViewPosition = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_SetGamePlayerViewAngle(void(*func)(const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_SetGamePlayerViewAngle = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetPointContents(int(*func)(const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetPointContents = func;
 }
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetStepHeight(float(*func)(const double*, const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::EXT_GetStepHeight = func;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetWaterSurfaceHeight(double(*func)(const double*, int*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::EXT_GetWaterSurfaceHeight = func;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetEntityVelocity(bool(*func)(int, double*, double*, double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::EXT_GetEntityVelocity = func;
+}
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_PointRaytrace(FreemanAPI::pmtrace_t*(*func)(const double*, const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_PointRaytrace = func;
 }
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_PointRaytraceBatch(void(*func)(const double*, const double*, int, FreemanAPI::pmtrace_t*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::EXT_PointRaytraceBatch = func;
+}
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_PM_PlayerTrace(FreemanAPI::pmtrace_t*(*func)(const double*, const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_PM_PlayerTrace = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_PM_PlayerTraceDown(FreemanAPI::pmtrace_t*(*func)(const double*, const double*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_PM_PlayerTraceDown = func;
 }
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_PM_PlayerTraceBatch(void(*func)(const FreemanAPI::FreemanHullTrace*, int, FreemanAPI::pmtrace_t*)) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::EXT_PM_PlayerTraceBatch = func;
+}
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveLeftRight(float(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveLeftRight = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveFwdBack(float(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveFwdBack = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveUpDown(float(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveUpDown = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveJump(bool(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveJump = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveDuck(bool(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveDuck = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveRun(bool(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveRun = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_GetGameMoveUse(bool(*func)()) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_GetGameMoveUse = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Register_OnTakeFallDamage(void(*func)(float)) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::EXT_OnTakeFallDamage = func;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetIsZUp(bool on) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	if (on) {
 		NyaMat4x4::bZUp = true;
 		FreemanAPI::FORWARD = 1;
@@ -74,12 +116,15 @@ extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetIsZUp(bool on) {
 	}
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetConvertUnits(bool on) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::bConvertUnits = on;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetUnitSize(float f) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::fUnitsConversion = f;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetUnitInvertXYZ(bool x, bool y, bool z) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::vXYZUnitsMult.x = x ? -1 : 1;
 	FreemanAPI::vXYZUnitsMult.y = y ? -1 : 1;
 	FreemanAPI::vXYZUnitsMult.z = z ? -1 : 1;
@@ -90,52 +135,289 @@ extern "C" __declspec(dllexport) void __cdecl FreemanAPI_GetRotateOrder(int* pit
 	if (roll) *roll = FreemanAPI::ROLL;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetRotateOrder(int pitch, int yaw, int roll) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	if (pitch >= 0 && pitch <= 2) FreemanAPI::PITCH = pitch;
 	if (yaw >= 0 && yaw <= 2) FreemanAPI::YAW = yaw;
 	if (roll >= 0 && roll <= 2) FreemanAPI::ROLL = roll;
 }
-extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Process(double delta) {
+// whichever of Process and StepContexts comes first
+static void FreemanAPI_ResetOnce() {
 	static bool bOnce = true;
 	if (bOnce) {
 		FreemanAPI::Reset();
 		bOnce = false;
 	}
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_Process(double delta) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI_ResetOnce();
 
 	FreemanAPI::Process(delta);
 }
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_StepContexts(const int* ids, int numIds, double delta) {
+	if (FreemanAPI::bSimThreadRunning) return -1;
+	if (!ids || numIds <= 0) return -1;
+	FreemanAPI_ResetOnce();
+
+	return FreemanAPI::StepContexts(ids, numIds, delta);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetLockstepBatching(bool on) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::bLockstepBatching = on;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetFrameBudgetMicros(int micros) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::nFrameBudgetMicros = micros;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_GetStats(FreemanAPI::FreemanStats* out) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	if (!out) return;
+	memcpy(out, &FreemanAPI::stats, std::min(out->size, sizeof(FreemanAPI::stats)));
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ResetStats() {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::ResetStats();
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetStatsPerFrame(bool on) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::bStatsPerFrame = on;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_GetLatencyStats(FreemanAPI::FreemanLatencyStats* out) {
+	if (!out) return;
+	FreemanAPI::FreemanLatencyStats latency;
+	FreemanAPI::GetLatencyStats(&latency);
+	memcpy(out, &latency, std::min(out->size, sizeof(latency)));
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ResetLatencyStats() {
+	FreemanAPI::ResetLatencyStats();
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetTimelineEnabled(bool on) {
+	FreemanAPI::bTimelineEnabled = on;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ClearTimeline() {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::ClearTimeline();
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_DumpTimeline(const char* path) {
+	return FreemanAPI::DumpTimeline(path);
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_StartRecording(const char* path) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	return FreemanAPI::StartRecording(path);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_StopRecording() {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::StopRecording();
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_ReplayRecording(const char* path, FreemanAPI::FreemanReplayResult* out) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	return FreemanAPI::ReplayRecording(path, out);
+}
+extern "C" __declspec(dllexport) size_t __cdecl FreemanAPI_GetStateSize() {
+	return FreemanAPI::GetStateSize();
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SaveState(uint8_t* out) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	if (!out) return;
+	FreemanAPI::SaveState(out);
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_LoadState(const uint8_t* data, size_t size) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	if (!data) return false;
+	return FreemanAPI::LoadState(data, size);
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_Rollback(const uint8_t* state, size_t stateSize, const FreemanAPI::FreemanInputFrame* inputs, int numInputs) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	if (!state || (numInputs > 0 && !inputs)) return false;
+	return FreemanAPI::Rollback(state, stateSize, inputs, numInputs);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetNetPrecision(double originStep, double velocityStep, int angleBits) {
+	if (originStep > 0) FreemanAPI::fNetOriginPrecision = originStep;
+	if (velocityStep > 0) FreemanAPI::fNetVelocityPrecision = velocityStep;
+	if (angleBits >= 8 && angleBits <= 30) FreemanAPI::nNetAngleBits = angleBits;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_GetNetState(FreemanAPI::FreemanNetState* out) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	if (!out) return;
+	FreemanAPI::GetNetState(out);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetNetState(const FreemanAPI::FreemanNetState* in) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	if (!in) return;
+	FreemanAPI::SetNetState(in);
+	FreemanAPI::GetContext()->view.bDirty = true;
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_EncodeNetStates(const FreemanAPI::FreemanNetState* states, const FreemanAPI::FreemanNetState* baselines, int numPlayers, uint8_t* out, int outSize) {
+	if (!states || !out || numPlayers <= 0) return -1;
+	return FreemanAPI::EncodeNetStates(states, baselines, numPlayers, out, outSize);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_DecodeNetStates(const uint8_t* in, int inSize, const FreemanAPI::FreemanNetState* baselines, int numPlayers, FreemanAPI::FreemanNetState* out) {
+	if (!in || !out || numPlayers <= 0) return -1;
+	return FreemanAPI::DecodeNetStates(in, inSize, baselines, numPlayers, out);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_CreateContext() {
+	if (FreemanAPI::bSimThreadRunning) return -1;
+	return FreemanAPI::CreateContext();
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_DestroyContext(int id) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::DestroyContext(id);
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_SetContext(int id) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	return FreemanAPI::SetContext(id);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_GetContext() {
+	return FreemanAPI::GetContextID();
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetSimTime(double time) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::pmove->flSimTime = time;
+}
+extern "C" __declspec(dllexport) double __cdecl FreemanAPI_GetSimTime() {
+	if (FreemanAPI::bSimThreadRunning) return 0;
+	return FreemanAPI::pmove->flSimTime;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetCarriedYaw(double yaw) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::pmove->flCarriedYaw = yaw;
+}
+extern "C" __declspec(dllexport) double __cdecl FreemanAPI_GetCarriedYaw() {
+	if (FreemanAPI::bSimThreadRunning) return 0;
+	return FreemanAPI::pmove->flCarriedYaw;
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetHullHistoryLength(int length) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::SetHullHistoryLength(length);
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_GetHullAtTime(double time, FreemanAPI::FreemanHullSample* out) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	if (!out) return false;
+	return FreemanAPI::GetHullAtTime(time, out);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_RewindAllContexts(double time, FreemanAPI::FreemanHullSample* out, int maxContexts) {
+	if (FreemanAPI::bSimThreadRunning) return 0;
+	if (!out) return 0;
+	return FreemanAPI::RewindAllContexts(time, out, maxContexts);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_GetTouches(FreemanAPI::FreemanTouch* out, int maxTouches) {
+	if (FreemanAPI::bSimThreadRunning) return 0;
+	if (!out) maxTouches = 0;
+	return FreemanAPI::GetTouches(out, maxTouches);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_GetView(double* origin, double* angles) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	NyaVec3Double eye, viewAngles;
+	FreemanAPI::GetView(&eye, &viewAngles);
+	for (int i = 0; i < 3; i++) {
+		if (origin) origin[i] = eye[i];
+		if (angles) angles[i] = viewAngles[i];
+	}
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_QueueInputEvent(const FreemanAPI::FreemanInputEvent* event) {
+	if (FreemanAPI::bSimThreadRunning) return false;
+	if (!event) return false;
+	return FreemanAPI::QueueInputEvent(*event);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ClearInputEvents() {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::ClearInputEvents();
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_StartSimThread(double tickRate, bool callbacksThreadSafe) {
+	return FreemanAPI::StartSimThread(tickRate, callbacksThreadSafe);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_StopSimThread() {
+	FreemanAPI::StopSimThread();
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_PushSimInput(const FreemanAPI::FreemanInputFrame* input) {
+	if (!input) return false;
+	return FreemanAPI::PushSimInput(input);
+}
+extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_PollSimThread(FreemanAPI::FreemanSimFrame* out) {
+	return FreemanAPI::PollSimThread(out);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_AddWaterBox(const double* mins, const double* maxs, int contents) {
+	if (FreemanAPI::bSimThreadRunning) return -1;
+	if (!mins || !maxs) return -1;
+	return FreemanAPI::AddWaterBox(mins, maxs, contents);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_AddWaterHull(const double* planes, int numPlanes, const double* mins, const double* maxs, int contents) {
+	if (FreemanAPI::bSimThreadRunning) return -1;
+	if (!planes || numPlanes <= 0 || !mins || !maxs) return -1;
+	return FreemanAPI::AddWaterHull(planes, numPlanes, mins, maxs, contents);
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_AddWaterPlane(double height, int contents) {
+	if (FreemanAPI::bSimThreadRunning) return -1;
+	return FreemanAPI::AddWaterPlane(height, contents);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_RemoveWaterVolume(int id) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::RemoveWaterVolume(id);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ClearWaterVolumes() {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::ClearWaterVolumes();
+}
+extern "C" __declspec(dllexport) int __cdecl FreemanAPI_AddLadder(const double* center, const double* normal, double width, double height, double depth) {
+	if (FreemanAPI::bSimThreadRunning) return -1;
+	if (!center || !normal) return -1;
+	return FreemanAPI::AddLadder(center, normal, width, height, depth);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_RemoveLadder(int id) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::RemoveLadder(id);
+}
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ClearLadders() {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::ClearLadders();
+}
 #ifdef FREEMANAPI_FOUC_MENULIB
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ProcessChloeMenu() {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::ProcessMenu();
 }
 #endif
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ResetPhysics() {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::Reset();
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_ToggleNoclip() {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::ToggleNoclip();
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetMoveType(int type) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::pmove->movetype = type;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetDefaultMoveType(int type) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::nDefaultMoveType = type;
 }
+extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetRandomSeed(uint64_t seed) {
+	if (FreemanAPI::bSimThreadRunning) return;
+	FreemanAPI::nRandomSeed = seed;
+	FreemanAPI::pmove->random.Seed(seed);
+}
 extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_GetIsEnabled() {
 	return FreemanAPI::bEnabled;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetIsEnabled(bool on) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::bEnabled = on;
 }
 extern "C" __declspec(dllexport) bool __cdecl FreemanAPI_GetIsHL2Mode() {
 	return FreemanAPI::bHL2Mode;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetIsHL2Mode(bool on) {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::bHL2Mode = on;
 }
 extern "C" __declspec(dllexport) double* __cdecl FreemanAPI_GetPlayerBBoxMin() {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	return &FreemanAPI::pmove->player_mins[FreemanAPI::GetPlayerHullID()].x;
 }
 extern "C" __declspec(dllexport) double* __cdecl FreemanAPI_GetPlayerBBoxMax() {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	return &FreemanAPI::pmove->player_maxs[FreemanAPI::GetPlayerHullID()].x;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_RegisterCustomBoolean(const char* label, const char* configLabel, bool* ptr, int category) {
@@ -152,57 +434,69 @@ extern "C" __declspec(dllexport) void __cdecl FreemanAPI_SetConfigName(const cha
 	FreemanAPI::sConfigName = name;
 }
 extern "C" __declspec(dllexport) void __cdecl FreemanAPI_LoadConfig() {
+	if (FreemanAPI::bSimThreadRunning) return;
 	FreemanAPI::LoadConfig();
 }
 extern "C" __declspec(dllexport) float __cdecl FreemanAPI_GetPlayerVelocity() {
+	if (FreemanAPI::bSimThreadRunning) return 0;
 	return FreemanAPI::pmove->velocity.length();
 }
 extern "C" __declspec(dllexport) float __cdecl FreemanAPI_GetPlayerVelocity2D() {
+	if (FreemanAPI::bSimThreadRunning) return 0;
 	auto vel = FreemanAPI::pmove->velocity;
 	vel[FreemanAPI::UP] = 0;
 	return vel.length();
 }
 extern "C" __declspec(dllexport) bool* __cdecl FreemanAPI_GetConfigBoolean(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValue(label);
 	if (!config) return nullptr;
 	return config->bValue;
 }
 extern "C" __declspec(dllexport) int* __cdecl FreemanAPI_GetConfigInt(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValue(label);
 	if (!config) return nullptr;
 	return config->iValue;
 }
 extern "C" __declspec(dllexport) float* __cdecl FreemanAPI_GetConfigFloat(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValue(label);
 	if (!config) return nullptr;
 	return config->fValue;
 }
 extern "C" __declspec(dllexport) bool* __cdecl FreemanAPI_GetConfigBooleanHL1(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValueHL1(label);
 	if (!config) return nullptr;
 	return config->bValue;
 }
 extern "C" __declspec(dllexport) int* __cdecl FreemanAPI_GetConfigIntHL1(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValueHL1(label);
 	if (!config) return nullptr;
 	return config->iValue;
 }
 extern "C" __declspec(dllexport) float* __cdecl FreemanAPI_GetConfigFloatHL1(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValueHL1(label);
 	if (!config) return nullptr;
 	return config->fValue;
 }
 extern "C" __declspec(dllexport) bool* __cdecl FreemanAPI_GetConfigBooleanHL2(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValueHL2(label);
 	if (!config) return nullptr;
 	return config->bValue;
 }
 extern "C" __declspec(dllexport) int* __cdecl FreemanAPI_GetConfigIntHL2(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValueHL2(label);
 	if (!config) return nullptr;
 	return config->iValue;
 }
 extern "C" __declspec(dllexport) float* __cdecl FreemanAPI_GetConfigFloatHL2(const char* label) {
+	if (FreemanAPI::bSimThreadRunning) return nullptr;
 	auto config = FreemanAPI::FindConfigValueHL2(label);
 	if (!config) return nullptr;
 	return config->fValue;
@@ -1,8 +1,8 @@
 // HL to game integration
 namespace FreemanAPI {
-	std::vector<tConfigValue> aCustomBehaviorConfig;
-	std::vector<tConfigValue> aCustomCVarConfig;
-	std::vector<tConfigValue> aCustomAdvancedConfig;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aCustomBehaviorConfig;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aCustomCVarConfig;
+	FREEMANAPI_THREAD_LOCAL std::vector<tConfigValue> aCustomAdvancedConfig;
 	std::vector<tConfigValue>* GetCustomConfig(int category) {
 		std::vector<tConfigValue>* vec = nullptr;
 		switch (category) {
@@ -98,91 +98,204 @@ namespace FreemanAPI {
 		return nullptr;
 	}
 
-	auto EXT_PlayGameSound = (void(*)(const char*, float))nullptr;
-	auto EXT_GetGamePlayerDead = (bool(*)())nullptr;
-	auto EXT_GetGamePlayerPosition = (void(*)(double*))nullptr;
-	auto EXT_GetGamePlayerVelocity = (void(*)(double*))nullptr;
-	auto EXT_GetGamePlayerViewAngle = (void(*)(double*))nullptr;
-	auto EXT_SetGamePlayerPosition = (void(*)(const double*, const double*))nullptr;
-	auto EXT_SetGamePlayerPositionRaw = (void(*)(const double*, const double*))nullptr;
-	auto EXT_SetGamePlayerViewPosition = (void(*)(const double*))nullptr;
-	auto EXT_SetGamePlayerViewAngle = (void(*)(const double*))nullptr;
-	auto EXT_GetPointContents = (int(*)(const double*))nullptr;
-	auto EXT_PointRaytrace = (pmtrace_t*(*)(const double*, const double*))nullptr;
-	auto EXT_PM_PlayerTrace = (pmtrace_t*(*)(const double*, const double*))nullptr;
-	auto EXT_PM_PlayerTraceDown = (pmtrace_t*(*)(const double*, const double*))nullptr;
-	auto EXT_GetGameMoveLeftRight = (float(*)())nullptr;
-	auto EXT_GetGameMoveFwdBack = (float(*)())nullptr;
-	auto EXT_GetGameMoveUpDown = (float(*)())nullptr;
-	auto EXT_GetGameMoveJump = (bool(*)())nullptr;
-	auto EXT_GetGameMoveDuck = (bool(*)())nullptr;
-	auto EXT_GetGameMoveRun = (bool(*)())nullptr;
-	auto EXT_GetGameMoveUse = (bool(*)())nullptr;
-	auto EXT_OnTakeFallDamage = (void(*)(float))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_PlayGameSound = (void(*)(const char*, float))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGamePlayerDead = (bool(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGamePlayerPosition = (void(*)(double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGamePlayerVelocity = (void(*)(double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGamePlayerViewAngle = (void(*)(double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_SetGamePlayerPosition = (void(*)(const double*, const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_SetGamePlayerPositionRaw = (void(*)(const double*, const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_SetGamePlayerViewPosition = (void(*)(const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_SetGamePlayerViewAngle = (void(*)(const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetPointContents = (int(*)(const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_PointRaytrace = (pmtrace_t*(*)(const double*, const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_PointRaytraceBatch = (void(*)(const double*, const double*, int, pmtrace_t*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_PM_PlayerTrace = (pmtrace_t*(*)(const double*, const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_PM_PlayerTraceDown = (pmtrace_t*(*)(const double*, const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_PM_PlayerTraceBatch = (void(*)(const FreemanHullTrace*, int, pmtrace_t*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetStepHeight = (float(*)(const double*, const double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetWaterSurfaceHeight = (double(*)(const double*, int*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetEntityVelocity = (bool(*)(int, double*, double*, double*))nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveLeftRight = (float(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveFwdBack = (float(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveUpDown = (float(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveJump = (bool(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveDuck = (bool(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveRun = (bool(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_GetGameMoveUse = (bool(*)())nullptr;
+	FREEMANAPI_THREAD_LOCAL auto EXT_OnTakeFallDamage = (void(*)(float))nullptr;
+
+	// every host callback, for swapping them all out at once
+	struct tGameCallbacks {
+		decltype(EXT_PlayGameSound) PlayGameSound;
+		decltype(EXT_GetGamePlayerDead) GetGamePlayerDead;
+		decltype(EXT_GetGamePlayerPosition) GetGamePlayerPosition;
+		decltype(EXT_GetGamePlayerVelocity) GetGamePlayerVelocity;
+		decltype(EXT_GetGamePlayerViewAngle) GetGamePlayerViewAngle;
+		decltype(EXT_SetGamePlayerPosition) SetGamePlayerPosition;
+		decltype(EXT_SetGamePlayerPositionRaw) SetGamePlayerPositionRaw;
+		decltype(EXT_SetGamePlayerViewPosition) SetGamePlayerViewPosition;
+		decltype(EXT_SetGamePlayerViewAngle) SetGamePlayerViewAngle;
+		decltype(EXT_GetPointContents) GetPointContents;
+		decltype(EXT_PointRaytrace) PointRaytrace;
+		decltype(EXT_PointRaytraceBatch) PointRaytraceBatch;
+		decltype(EXT_PM_PlayerTrace) PM_PlayerTrace;
+		decltype(EXT_PM_PlayerTraceDown) PM_PlayerTraceDown;
+		decltype(EXT_PM_PlayerTraceBatch) PM_PlayerTraceBatch;
+		decltype(EXT_GetStepHeight) GetStepHeight;
+		decltype(EXT_GetWaterSurfaceHeight) GetWaterSurfaceHeight;
+		decltype(EXT_GetEntityVelocity) GetEntityVelocity;
+		decltype(EXT_GetGameMoveLeftRight) GetGameMoveLeftRight;
+		decltype(EXT_GetGameMoveFwdBack) GetGameMoveFwdBack;
+		decltype(EXT_GetGameMoveUpDown) GetGameMoveUpDown;
+		decltype(EXT_GetGameMoveJump) GetGameMoveJump;
+		decltype(EXT_GetGameMoveDuck) GetGameMoveDuck;
+		decltype(EXT_GetGameMoveRun) GetGameMoveRun;
+		decltype(EXT_GetGameMoveUse) GetGameMoveUse;
+		decltype(EXT_OnTakeFallDamage) OnTakeFallDamage;
+
+		void Save() {
+			PlayGameSound = EXT_PlayGameSound;
+			GetGamePlayerDead = EXT_GetGamePlayerDead;
+			GetGamePlayerPosition = EXT_GetGamePlayerPosition;
+			GetGamePlayerVelocity = EXT_GetGamePlayerVelocity;
+			GetGamePlayerViewAngle = EXT_GetGamePlayerViewAngle;
+			SetGamePlayerPosition = EXT_SetGamePlayerPosition;
+			SetGamePlayerPositionRaw = EXT_SetGamePlayerPositionRaw;
+			SetGamePlayerViewPosition = EXT_SetGamePlayerViewPosition;
+			SetGamePlayerViewAngle = EXT_SetGamePlayerViewAngle;
+			GetPointContents = EXT_GetPointContents;
+			PointRaytrace = EXT_PointRaytrace;
+			PointRaytraceBatch = EXT_PointRaytraceBatch;
+			PM_PlayerTrace = EXT_PM_PlayerTrace;
+			PM_PlayerTraceDown = EXT_PM_PlayerTraceDown;
+			PM_PlayerTraceBatch = EXT_PM_PlayerTraceBatch;
+			GetStepHeight = EXT_GetStepHeight;
+			GetWaterSurfaceHeight = EXT_GetWaterSurfaceHeight;
+			GetEntityVelocity = EXT_GetEntityVelocity;
+			GetGameMoveLeftRight = EXT_GetGameMoveLeftRight;
+			GetGameMoveFwdBack = EXT_GetGameMoveFwdBack;
+			GetGameMoveUpDown = EXT_GetGameMoveUpDown;
+			GetGameMoveJump = EXT_GetGameMoveJump;
+			GetGameMoveDuck = EXT_GetGameMoveDuck;
+			GetGameMoveRun = EXT_GetGameMoveRun;
+			GetGameMoveUse = EXT_GetGameMoveUse;
+			OnTakeFallDamage = EXT_OnTakeFallDamage;
+		}
+
+		void Restore() const {
+			EXT_PlayGameSound = PlayGameSound;
+			EXT_GetGamePlayerDead = GetGamePlayerDead;
+			EXT_GetGamePlayerPosition = GetGamePlayerPosition;
+			EXT_GetGamePlayerVelocity = GetGamePlayerVelocity;
+			EXT_GetGamePlayerViewAngle = GetGamePlayerViewAngle;
+			EXT_SetGamePlayerPosition = SetGamePlayerPosition;
+			EXT_SetGamePlayerPositionRaw = SetGamePlayerPositionRaw;
+			EXT_SetGamePlayerViewPosition = SetGamePlayerViewPosition;
+			EXT_SetGamePlayerViewAngle = SetGamePlayerViewAngle;
+			EXT_GetPointContents = GetPointContents;
+			EXT_PointRaytrace = PointRaytrace;
+			EXT_PointRaytraceBatch = PointRaytraceBatch;
+			EXT_PM_PlayerTrace = PM_PlayerTrace;
+			EXT_PM_PlayerTraceDown = PM_PlayerTraceDown;
+			EXT_PM_PlayerTraceBatch = PM_PlayerTraceBatch;
+			EXT_GetStepHeight = GetStepHeight;
+			EXT_GetWaterSurfaceHeight = GetWaterSurfaceHeight;
+			EXT_GetEntityVelocity = GetEntityVelocity;
+			EXT_GetGameMoveLeftRight = GetGameMoveLeftRight;
+			EXT_GetGameMoveFwdBack = GetGameMoveFwdBack;
+			EXT_GetGameMoveUpDown = GetGameMoveUpDown;
+			EXT_GetGameMoveJump = GetGameMoveJump;
+			EXT_GetGameMoveDuck = GetGameMoveDuck;
+			EXT_GetGameMoveRun = GetGameMoveRun;
+			EXT_GetGameMoveUse = GetGameMoveUse;
+			EXT_OnTakeFallDamage = OnTakeFallDamage;
+		}
+	};
 
 	void OnTakeFallDamage(float dmg) {
 		if (!EXT_OnTakeFallDamage) return;
+		FREEMANAPI_STAT_INC(numFallDamageCalls);
 		EXT_OnTakeFallDamage(dmg);
 	}
 
 	void PlayGameSound(const std::string& path, float volume) {
 		if (!EXT_PlayGameSound) return;
+		FREEMANAPI_STAT_INC(numSoundCalls);
 		EXT_PlayGameSound(path.c_str(), volume);
 	}
 
 	bool GetGamePlayerDead() {
-		if (EXT_GetGamePlayerDead) return EXT_GetGamePlayerDead();
-		return false;
+		if (!EXT_GetGamePlayerDead) return false;
+		FREEMANAPI_STAT_INC(numPlayerStateCalls);
+		bool dead = EXT_GetGamePlayerDead();
+		RecordReplayInt(REPLAY_DEAD, dead);
+		return dead;
 	}
 
 	void GetGamePlayerPosition(NyaVec3Double* out) {
 		*out = {0,0,0};
 		if (EXT_GetGamePlayerPosition) {
+			FREEMANAPI_STAT_INC(numPlayerStateCalls);
 			EXT_GetGamePlayerPosition(&out->x);
+			RecordReplayVector(REPLAY_POSITION, *out);
 		}
 	}
 
 	void GetGamePlayerVelocity(NyaVec3Double* out) {
 		*out = {0,0,0};
 		if (EXT_GetGamePlayerVelocity) {
+			FREEMANAPI_STAT_INC(numPlayerStateCalls);
 			EXT_GetGamePlayerVelocity(&out->x);
+			RecordReplayVector(REPLAY_VELOCITY, *out);
 		}
 	}
 
 	void GetGamePlayerViewAngle(NyaVec3Double* out) {
 		*out = {0,0,0};
 		if (EXT_GetGamePlayerViewAngle) {
+			FREEMANAPI_STAT_INC(numPlayerStateCalls);
 			EXT_GetGamePlayerViewAngle(&out->x);
+			RecordReplayVector(REPLAY_VIEWANGLE, *out);
 		}
 	}
 
 	void SetGamePlayerPosition(const NyaVec3Double* in, const NyaVec3Double* inVelocity) {
 		if (!EXT_SetGamePlayerPosition) return;
+		FREEMANAPI_STAT_INC(numPlayerOutputCalls);
 		EXT_SetGamePlayerPosition(&in->x, &inVelocity->x);
 	}
 
 	void SetGamePlayerPositionRaw(const NyaVec3Double* in, const NyaVec3Double* inVelocity) {
 		if (!EXT_SetGamePlayerPositionRaw) return;
+		FREEMANAPI_STAT_INC(numPlayerOutputCalls);
 		EXT_SetGamePlayerPositionRaw(&in->x, &inVelocity->x);
 	}
 
 	void SetGamePlayerViewPosition(const NyaVec3Double* in) {
 		if (!EXT_SetGamePlayerViewPosition) return;
+		FREEMANAPI_STAT_INC(numPlayerOutputCalls);
 		EXT_SetGamePlayerViewPosition(&in->x);
 	}
 
 	void SetGamePlayerViewAngle(const NyaVec3Double* in) {
 		if (!EXT_SetGamePlayerViewAngle) return;
+		FREEMANAPI_STAT_INC(numPlayerOutputCalls);
 		EXT_SetGamePlayerViewAngle(&in->x);
 	}
 
 	int GetPointContentsGame(const NyaVec3Double* point) {
 		if (!EXT_GetPointContents) return CONTENTS_EMPTY;
-		return EXT_GetPointContents(&point->x);
+		FREEMANAPI_STAT_INC(numPointContentsCalls);
+		FREEMANAPI_TIMELINE_SCOPE("EXT_GetPointContents");
+		FREEMANAPI_LATENCY_SAMPLED_SCOPE(histPointContents, numPointContentsCalls);
+		int contents = EXT_GetPointContents(&point->x);
+		RecordReplayInt(REPLAY_POINTCONTENTS, contents);
+		return contents;
 	}
 
 	pmtrace_t* PointRaytraceGame(const NyaVec3Double* _origin, const NyaVec3Double* _end) {
-		static pmtrace_t trace;
+		static FREEMANAPI_THREAD_LOCAL pmtrace_t trace;
 		trace.allsolid = false;
 		trace.startsolid = false;
 		trace.inopen = true;
@@ -197,13 +310,52 @@ namespace FreemanAPI {
 		auto func = EXT_PointRaytrace;
 		if (!func) func = EXT_PM_PlayerTrace;
 		if (func) {
+			FREEMANAPI_STAT_INC(numPointRaytraceCalls);
+			FREEMANAPI_TIMELINE_SCOPE("EXT_PointRaytrace");
+			FREEMANAPI_LATENCY_SAMPLED_SCOPE(histPointRaytrace, numPointRaytraceCalls);
 			trace = *func(&_origin->x, &_end->x);
+			RecordReplayTrace(REPLAY_POINTRAYTRACE, &trace, _end);
 		}
 		return &trace;
 	}
 
+	// independent rays all at once, one call to the host's batch callback if it has one
+	// starts and ends are handed over as flat arrays of xyz
+	static_assert(sizeof(NyaVec3Double) == sizeof(double) * 3, "NyaVec3Double arrays have to be flat xyz");
+	void PointRaytraceBatchGame(const NyaVec3Double* starts, const NyaVec3Double* ends, int count, pmtrace_t* out) {
+		if (!EXT_PointRaytraceBatch) {
+			for (int i = 0; i < count; i++) {
+				out[i] = *PointRaytraceGame(&starts[i], &ends[i]);
+			}
+			return;
+		}
+
+		for (int i = 0; i < count; i++) {
+			auto& trace = out[i];
+			trace.allsolid = false;
+			trace.startsolid = false;
+			trace.inopen = true;
+			trace.inwater = false;
+			trace.fraction = 1.0f;
+			trace.endpos = ends[i];
+			trace.plane.normal = {0,0,0};
+			trace.plane.dist = 9999;
+			trace.ent = -1;
+			trace.surfaceId = 0;
+		}
+		FREEMANAPI_STAT_INC(numPointRaytraceBatchCalls);
+		{
+			FREEMANAPI_TIMELINE_SCOPE("EXT_PointRaytraceBatch");
+			EXT_PointRaytraceBatch(&starts[0].x, &ends[0].x, count, out);
+		}
+		// recorded one by one, a replay serves them back through the single ray callback in the same order
+		for (int i = 0; i < count; i++) {
+			RecordReplayTrace(REPLAY_POINTRAYTRACE, &out[i], &ends[i]);
+		}
+	}
+
 	pmtrace_t* PM_PlayerTraceGame(const NyaVec3Double* _origin, const NyaVec3Double* _end) {
-		static pmtrace_t trace;
+		static FREEMANAPI_THREAD_LOCAL pmtrace_t trace;
 		trace.allsolid = false;
 		trace.startsolid = false;
 		trace.inopen = true;
@@ -215,13 +367,29 @@ namespace FreemanAPI {
 		trace.ent = -1;
 		trace.surfaceId = 0;
 		if (EXT_PM_PlayerTrace) {
+			FREEMANAPI_STAT_INC(numPlayerTraceCalls);
+			FREEMANAPI_TIMELINE_SCOPE("EXT_PM_PlayerTrace");
+			FREEMANAPI_LATENCY_SAMPLED_SCOPE(histPlayerTrace, numPlayerTraceCalls);
 			trace = *EXT_PM_PlayerTrace(&_origin->x, &_end->x);
+			RecordReplayTrace(REPLAY_PLAYERTRACE, &trace, _end);
 		}
 		return &trace;
 	}
 
+	// the traces in a batch aren't counted in numPlayerTraceCalls
+	void PM_PlayerTraceBatchGame(const FreemanHullTrace* traces, int count, pmtrace_t* out) {
+		for (int i = 0; i < count; i++) {
+			auto& trace = out[i];
+			trace.Default();
+			trace.endpos = { traces[i].end[0], traces[i].end[1], traces[i].end[2] };
+		}
+		FREEMANAPI_STAT_INC(numPlayerTraceBatchCalls);
+		FREEMANAPI_TIMELINE_SCOPE("EXT_PM_PlayerTraceBatch");
+		EXT_PM_PlayerTraceBatch(traces, count, out);
+	}
+
 	pmtrace_t* PM_PlayerTraceDownGame(const NyaVec3Double* _origin, const NyaVec3Double* _end) {
-		static pmtrace_t trace;
+		static FREEMANAPI_THREAD_LOCAL pmtrace_t trace;
 		trace.allsolid = false;
 		trace.startsolid = false;
 		trace.inopen = true;
@@ -236,11 +404,113 @@ namespace FreemanAPI {
 		auto func = EXT_PM_PlayerTraceDown;
 		if (!func) func = EXT_PM_PlayerTrace;
 		if (func) {
+			FREEMANAPI_STAT_INC(numPlayerTraceDownCalls);
+			FREEMANAPI_TIMELINE_SCOPE("EXT_PM_PlayerTraceDown");
 			trace = *func(&_origin->x, &_end->x);
+			RecordReplayTrace(REPLAY_PLAYERTRACEDOWN, &trace, _end);
 		}
 		return &trace;
 	}
 
+	// STEP_HEIGHT_UNKNOWN if the host can't tell
+	float GetStepHeightGame(const NyaVec3Double* origin, const NyaVec3Double* dest) {
+		if (!EXT_GetStepHeight) return STEP_HEIGHT_UNKNOWN;
+		FREEMANAPI_STAT_INC(numStepHeightCalls);
+		float height = EXT_GetStepHeight(&origin->x, &dest->x);
+		RecordReplayFloat(REPLAY_STEPHEIGHT, height);
+		return height;
+	}
+
+	// contents at the point and the height of the water surface above it, contents is empty if the point is dry
+	double GetWaterSurfaceHeightGame(const NyaVec3Double* point, int* contents) {
+		*contents = CONTENTS_EMPTY;
+		if (!EXT_GetWaterSurfaceHeight) return 0;
+		FREEMANAPI_STAT_INC(numWaterSurfaceCalls);
+		FREEMANAPI_TIMELINE_SCOPE("EXT_GetWaterSurfaceHeight");
+		double height = EXT_GetWaterSurfaceHeight(&point->x, contents);
+		if (IsRecordingReplay()) {
+			tReplayRecord record;
+			record.AddDouble(height);
+			record.AddInt(*contents);
+			replayWriter.Write(REPLAY_WATERSURFACE, record);
+		}
+		return height;
+	}
+
+	// pivot, velocity and angular velocity of an entity, false if it isn't moving
+	bool GetEntityVelocityGame(int ent, NyaVec3Double* origin, NyaVec3Double* velocity, NyaVec3Double* angular) {
+		*origin = *velocity = *angular = {0,0,0};
+		if (!EXT_GetEntityVelocity) return false;
+		FREEMANAPI_STAT_INC(numEntityVelocityCalls);
+		FREEMANAPI_TIMELINE_SCOPE("EXT_GetEntityVelocity");
+		bool moving = EXT_GetEntityVelocity(ent, &origin->x, &velocity->x, &angular->x);
+		if (IsRecordingReplay()) {
+			tReplayRecord record;
+			record.AddInt(moving);
+			record.AddVector(*origin);
+			record.AddVector(*velocity);
+			record.AddVector(*angular);
+			replayWriter.Write(REPLAY_ENTITYVELOCITY, record);
+		}
+		return moving;
+	}
+
+	float GetGameMoveLeftRight() {
+		if (!EXT_GetGameMoveLeftRight) return 0;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		float value = EXT_GetGameMoveLeftRight();
+		RecordReplayFloat(REPLAY_MOVE_LEFTRIGHT, value);
+		return value;
+	}
+
+	float GetGameMoveFwdBack() {
+		if (!EXT_GetGameMoveFwdBack) return 0;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		float value = EXT_GetGameMoveFwdBack();
+		RecordReplayFloat(REPLAY_MOVE_FWDBACK, value);
+		return value;
+	}
+
+	float GetGameMoveUpDown() {
+		if (!EXT_GetGameMoveUpDown) return 0;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		float value = EXT_GetGameMoveUpDown();
+		RecordReplayFloat(REPLAY_MOVE_UPDOWN, value);
+		return value;
+	}
+
+	bool GetGameMoveJump() {
+		if (!EXT_GetGameMoveJump) return false;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		bool value = EXT_GetGameMoveJump();
+		RecordReplayInt(REPLAY_MOVE_JUMP, value);
+		return value;
+	}
+
+	bool GetGameMoveDuck() {
+		if (!EXT_GetGameMoveDuck) return false;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		bool value = EXT_GetGameMoveDuck();
+		RecordReplayInt(REPLAY_MOVE_DUCK, value);
+		return value;
+	}
+
+	bool GetGameMoveRun() {
+		if (!EXT_GetGameMoveRun) return false;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		bool value = EXT_GetGameMoveRun();
+		RecordReplayInt(REPLAY_MOVE_RUN, value);
+		return value;
+	}
+
+	bool GetGameMoveUse() {
+		if (!EXT_GetGameMoveUse) return false;
+		FREEMANAPI_STAT_INC(numInputPollCalls);
+		bool value = EXT_GetGameMoveUse();
+		RecordReplayInt(REPLAY_MOVE_USE, value);
+		return value;
+	}
+
 	bool IsUsingPlayerTraceFallback() {
 		return !EXT_PM_PlayerTrace;
 	}
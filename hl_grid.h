@@ -0,0 +1,143 @@
+// uniform grid over the two horizontal axes for the volumes the host registers, water and ladders
+// a volume is anything with mins, maxs and IsActive(), ones without finite horizontal bounds go in a list that's always tested
+// cells are one flat id array with a start offset per cell, so a lookup is a single cell's run of ids
+namespace FreemanAPI {
+	const int VOLUME_GRID_MAX_CELLS = 128; // per axis
+
+	// volumes are registered in game space and stored in movement units
+	NyaVec3Double VolumePointToUnits(const double* in) {
+		NyaVec3Double point = { in[0], in[1], in[2] };
+		if (bConvertUnits) {
+			for (int i = 0; i < 3; i++) {
+				point[i] = MetersToUnits(point[i]);
+			}
+			point *= vXYZUnitsMult;
+		}
+		return point;
+	}
+
+	struct tVolumeGrid {
+		int axes[2];
+		double origin[2];
+		double cellSize;
+		double margin = 0; // volume bounds are grown by this much, a box up to this size around the point still finds them
+		int numCells[2];
+		std::vector<uint32_t> cellStart; // each cell's volumes are ids[cellStart[cell]] to ids[cellStart[cell + 1]]
+		std::vector<int> ids;
+		std::vector<int> unbounded;
+		int numVolumes = 0;
+		uint32_t revision = 0;
+		bool bBuilt = false;
+
+		template<typename T>
+		bool IsBounded(const T& volume) const {
+			for (int i = 0; i < 2; i++) {
+				if (!std::isfinite(volume.mins[axes[i]]) || !std::isfinite(volume.maxs[axes[i]])) return false;
+			}
+			return true;
+		}
+
+		bool GetCell(const NyaVec3Double& point, int& out) const {
+			int cell[2];
+			for (int i = 0; i < 2; i++) {
+				auto f = std::floor((point[axes[i]] - origin[i]) / cellSize);
+				if (f < 0 || f >= numCells[i]) return false;
+				cell[i] = (int)f;
+			}
+			out = cell[1] * numCells[0] + cell[0];
+			return true;
+		}
+
+		template<typename T>
+		void Build(const std::vector<T>& volumes, uint32_t newRevision, double minCellSize, double newMargin = 0) {
+			axes[0] = (UP + 1) % 3;
+			axes[1] = (UP + 2) % 3;
+			margin = newMargin;
+			ids.clear();
+			unbounded.clear();
+			cellStart.clear();
+			numVolumes = 0;
+
+			double mins[2] = { INFINITY, INFINITY };
+			double maxs[2] = { -INFINITY, -INFINITY };
+			for (int id = 0; id < (int)volumes.size(); id++) {
+				auto& volume = volumes[id];
+				if (!volume.IsActive()) continue;
+				numVolumes++;
+
+				if (!IsBounded(volume)) {
+					unbounded.push_back(id);
+					continue;
+				}
+				for (int i = 0; i < 2; i++) {
+					mins[i] = std::min(mins[i], volume.mins[axes[i]] - margin);
+					maxs[i] = std::max(maxs[i], volume.maxs[axes[i]] + margin);
+				}
+			}
+
+			numCells[0] = numCells[1] = 0;
+			if (numVolumes > (int)unbounded.size()) {
+				cellSize = std::max(minCellSize, 1.0);
+				for (int i = 0; i < 2; i++) {
+					cellSize = std::max(cellSize, (maxs[i] - mins[i]) / VOLUME_GRID_MAX_CELLS);
+				}
+				for (int i = 0; i < 2; i++) {
+					origin[i] = mins[i];
+					numCells[i] = std::min((int)((maxs[i] - mins[i]) / cellSize) + 1, VOLUME_GRID_MAX_CELLS);
+				}
+			}
+
+			// counting pass then a fill pass, so every cell's list is one contiguous run
+			int numAllCells = numCells[0] * numCells[1];
+			cellStart.assign(numAllCells + 1, 0);
+			for (int pass = 0; pass < 2; pass++) {
+				std::vector<uint32_t> fill;
+				if (pass) {
+					for (int i = 0; i < numAllCells; i++) {
+						cellStart[i + 1] += cellStart[i];
+					}
+					ids.resize(cellStart[numAllCells]);
+					fill.assign(cellStart.begin(), cellStart.end() - 1);
+				}
+
+				for (int id = 0; id < (int)volumes.size(); id++) {
+					auto& volume = volumes[id];
+					if (!volume.IsActive() || !IsBounded(volume)) continue;
+
+					int from[2], to[2];
+					for (int i = 0; i < 2; i++) {
+						from[i] = std::min((int)((volume.mins[axes[i]] - margin - origin[i]) / cellSize), numCells[i] - 1);
+						to[i] = std::min((int)((volume.maxs[axes[i]] + margin - origin[i]) / cellSize), numCells[i] - 1);
+					}
+					for (int y = from[1]; y <= to[1]; y++) {
+						for (int x = from[0]; x <= to[0]; x++) {
+							int cell = y * numCells[0] + x;
+							if (pass) ids[fill[cell]++] = id;
+							else cellStart[cell + 1]++;
+						}
+					}
+				}
+			}
+
+			revision = newRevision;
+			bBuilt = true;
+		}
+
+		// first id in the point's cell or the unbounded list that passes the test, -1 if none
+		template<typename F>
+		int Find(const NyaVec3Double& point, F test) const {
+			if (!numVolumes) return -1;
+
+			int cell;
+			if (GetCell(point, cell)) {
+				for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+					if (test(ids[i])) return ids[i];
+				}
+			}
+			for (int id : unbounded) {
+				if (test(id)) return id;
+			}
+			return -1;
+		}
+	};
+}
\ No newline at end of file
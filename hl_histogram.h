@@ -0,0 +1,170 @@
+#include <atomic>
+#include <bit>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define FREEMANAPI_LATENCY_TSC
+#endif
+
+// log-bucketed latency histograms, hdr style
+// samples are in clock ticks, each power of two is split into 16 linear sub-buckets so every bucket is within ~6% of its value
+// recording is a bucket lookup and a relaxed atomic add, no locks, so these can stay on in release builds
+// the two clock reads around a call are the expensive part so they're rdtsc on x86 instead of steady_clock
+// Process and the substeps time every call, the host callbacks run hundreds of times a frame so they only time every
+// LATENCY_SAMPLE_INTERVAL-th one, the percentiles hold up with that many samples but max would miss the spikes in between,
+// so theirs isn't reported
+namespace FreemanAPI {
+	struct tLatencyHistogram {
+		static const int SUB_BUCKET_BITS = 4;
+		static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+		static const int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+		std::atomic<uint32_t> counts[NUM_BUCKETS] = {};
+		std::atomic<uint64_t> max = 0;
+
+		static int GetBucket(uint64_t value) {
+			if (value < SUB_BUCKETS) return value;
+			int shift = std::bit_width(value) - SUB_BUCKET_BITS - 1;
+			return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+		}
+
+		// highest value that still lands in this bucket
+		static uint64_t GetBucketValue(int bucket) {
+			int shift = bucket / SUB_BUCKETS;
+			uint64_t sub = bucket % SUB_BUCKETS;
+			if (shift == 0) return sub;
+			return ((SUB_BUCKETS + sub + 1) << (shift - 1)) - 1;
+		}
+
+		void Record(uint64_t ticks) {
+			counts[GetBucket(ticks)].fetch_add(1, std::memory_order_relaxed);
+			auto last = max.load(std::memory_order_relaxed);
+			while (ticks > last && !max.compare_exchange_weak(last, ticks, std::memory_order_relaxed)) {}
+		}
+
+		void Reset() {
+			for (auto& count : counts) {
+				count.store(0, std::memory_order_relaxed);
+			}
+			max.store(0, std::memory_order_relaxed);
+		}
+
+		// samples recorded while this runs may or may not be included
+		// a sampled histogram's max is only the largest sample, it's left at 0 rather than passed off as the slowest call
+		void GetPercentiles(FreemanLatency* out, double nanosPerTick, bool sampled = false) {
+			uint64_t total = 0;
+			for (auto& count : counts) {
+				total += count.load(std::memory_order_relaxed);
+			}
+
+			const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+			float* outValues[] = { &out->p50, &out->p90, &out->p99, &out->p999 };
+			out->count = total;
+			float maxValue = max.load(std::memory_order_relaxed) * nanosPerTick / 1000.0;
+			out->max = sampled ? 0 : maxValue;
+
+			uint64_t seen = 0;
+			int bucket = 0;
+			for (int i = 0; i < 4; i++) {
+				*outValues[i] = 0;
+				if (!total) continue;
+
+				uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(total * percentiles[i]));
+				while (bucket < NUM_BUCKETS) {
+					auto count = counts[bucket].load(std::memory_order_relaxed);
+					if (seen + count >= target) break;
+					seen += count;
+					bucket++;
+				}
+				if (bucket >= NUM_BUCKETS) bucket = NUM_BUCKETS - 1;
+				*outValues[i] = std::min<float>(GetBucketValue(bucket) * nanosPerTick / 1000.0, maxValue);
+			}
+		}
+	};
+
+	tLatencyHistogram histProcess;
+	tLatencyHistogram histSubstep;
+	tLatencyHistogram histPlayerTrace;
+	tLatencyHistogram histPointRaytrace;
+	tLatencyHistogram histPointContents;
+
+	inline uint64_t GetProfileNanos() {
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	// only meaningful as a difference, the tsc runs at a constant rate on anything that still matters
+	inline uint64_t GetLatencyTicks() {
+#ifdef FREEMANAPI_LATENCY_TSC
+		return __rdtsc();
+#else
+		return GetProfileNanos();
+#endif
+	}
+
+	// the tsc rate isn't known up front, it's measured against steady_clock over the time since the library was loaded
+	struct tLatencyClockStart {
+		uint64_t ticks = GetLatencyTicks();
+		uint64_t nanos = GetProfileNanos();
+	} latencyClockStart;
+
+	double GetLatencyNanosPerTick() {
+#ifdef FREEMANAPI_LATENCY_TSC
+		// too short a baseline gives a rough rate, only happens if the stats are read right after loading
+		while (GetProfileNanos() - latencyClockStart.nanos < 10000000) {}
+		auto nanos = GetProfileNanos() - latencyClockStart.nanos;
+		auto ticks = GetLatencyTicks() - latencyClockStart.ticks;
+		return ticks ? nanos / (double)ticks : 1;
+#else
+		return 1;
+#endif
+	}
+
+	// a timed call costs two clock reads and a record, around 50-70ns, spread over this many calls it's under 20ns each
+	const uint32_t LATENCY_SAMPLE_INTERVAL = 8;
+
+	// time the current player spent parked while other players ran, see StepContexts, left out of every scope it falls into
+	FREEMANAPI_THREAD_LOCAL uint64_t nLatencyPausedTicks = 0;
+
+	struct tLatencyScope {
+		tLatencyHistogram* histogram;
+		uint64_t start;
+		uint64_t paused;
+
+		tLatencyScope(tLatencyHistogram& out) : histogram(&out), start(GetLatencyTicks()), paused(nLatencyPausedTicks) {}
+		// only times the call if it's a sampled one, callCount is the stats counter the caller just bumped
+		tLatencyScope(tLatencyHistogram& out, uint32_t callCount) : histogram(callCount % LATENCY_SAMPLE_INTERVAL ? nullptr : &out), start(histogram ? GetLatencyTicks() : 0), paused(nLatencyPausedTicks) {}
+		~tLatencyScope() {
+			if (!histogram) return;
+			histogram->Record(GetLatencyTicks() - start - (nLatencyPausedTicks - paused));
+		}
+	};
+
+	void GetLatencyStats(FreemanLatencyStats* out) {
+		auto nanosPerTick = GetLatencyNanosPerTick();
+		histProcess.GetPercentiles(&out->process, nanosPerTick);
+		histSubstep.GetPercentiles(&out->substep, nanosPerTick);
+		histPlayerTrace.GetPercentiles(&out->playerTrace, nanosPerTick, true);
+		histPointRaytrace.GetPercentiles(&out->pointRaytrace, nanosPerTick, true);
+		histPointContents.GetPercentiles(&out->pointContents, nanosPerTick, true);
+	}
+
+	void ResetLatencyStats() {
+		histProcess.Reset();
+		histSubstep.Reset();
+		histPlayerTrace.Reset();
+		histPointRaytrace.Reset();
+		histPointContents.Reset();
+	}
+}
+
+#ifndef FREEMANAPI_NO_STATS
+#define FREEMANAPI_LATENCY_SCOPE(name) FreemanAPI::tLatencyScope _latencyScope_##name(FreemanAPI::name)
+#define FREEMANAPI_LATENCY_SAMPLED_SCOPE(name, counter) FreemanAPI::tLatencyScope _latencyScope_##name(FreemanAPI::name, FreemanAPI::stats.counter)
+#else
+#define FREEMANAPI_LATENCY_SCOPE(name) ((void)0)
+#define FREEMANAPI_LATENCY_SAMPLED_SCOPE(name, counter) ((void)0)
+#endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+// ladders registered by the host, boxes turned to face their climb normal
+// the box is depth deep along the normal, width wide across it and height tall, the hull has to overlap it to climb
+// found through the same kind of grid as the water volumes, one cell lookup per substep
+namespace FreemanAPI {
+	struct tLadder {
+		NyaVec3Double center;
+		NyaVec3Double axes[3]; // climb normal pointing away from the wall, across, up
+		double extents[3]; // half the depth, width and height
+		NyaVec3Double mins, maxs; // bounds, for the grid
+		bool bActive = false;
+
+		bool IsActive() const {
+			return bActive;
+		}
+	};
+
+	FREEMANAPI_THREAD_LOCAL std::vector<tLadder> aLadders; // indexed by id
+	FREEMANAPI_THREAD_LOCAL uint32_t nLadderRevision = 0; // bumped on every change, replays log the ladders when it moves
+	FREEMANAPI_THREAD_LOCAL double fLadderCellSize = 128; // units
+	FREEMANAPI_THREAD_LOCAL tVolumeGrid ladderGrid;
+
+	// the normal is flattened onto the horizontal plane, returns -1 if there's nothing left of it
+	int AddLadder(const double* center, const double* normal, double width, double height, double depth) {
+		tLadder ladder;
+		ladder.center = VolumePointToUnits(center);
+
+		auto& climbNormal = ladder.axes[0];
+		climbNormal = { normal[0], normal[1], normal[2] };
+		if (bConvertUnits) climbNormal *= vXYZUnitsMult;
+		climbNormal[UP] = 0;
+		if (VectorNormalize(climbNormal) < 0.001) return -1;
+		ladder.axes[2] = {0,0,0};
+		ladder.axes[2][UP] = 1;
+		ladder.axes[1] = CrossProduct(ladder.axes[2], climbNormal);
+
+		ladder.extents[0] = depth;
+		ladder.extents[1] = width;
+		ladder.extents[2] = height;
+		for (auto& extent : ladder.extents) {
+			if (bConvertUnits) extent = MetersToUnits(extent);
+			extent = std::abs(extent) * 0.5;
+		}
+
+		for (int i = 0; i < 3; i++) {
+			double reach = 0;
+			for (int j = 0; j < 3; j++) {
+				reach += std::abs(ladder.axes[j][i]) * ladder.extents[j];
+			}
+			ladder.mins[i] = ladder.center[i] - reach;
+			ladder.maxs[i] = ladder.center[i] + reach;
+		}
+		ladder.bActive = true;
+
+		nLadderRevision++;
+		for (int i = 0; i < (int)aLadders.size(); i++) {
+			if (!aLadders[i].bActive) {
+				aLadders[i] = ladder;
+				return i;
+			}
+		}
+		aLadders.push_back(ladder);
+		return aLadders.size() - 1;
+	}
+
+	void RemoveLadder(int id) {
+		if (id < 0 || id >= (int)aLadders.size() || !aLadders[id].bActive) return;
+		aLadders[id] = {};
+		nLadderRevision++;
+	}
+
+	void ClearLadders() {
+		aLadders.clear();
+		nLadderRevision++;
+	}
+
+	// separating axis test on the world axes and the ladder's own, the edge pairs are left out
+	// so a hull right at a corner can count as touching a little early
+	bool IsTouchingLadder(const tLadder& ladder, const NyaVec3Double& center, const NyaVec3Double& half) {
+		auto delta = center - ladder.center;
+		for (int i = 0; i < 3; i++) {
+			if (std::abs(delta[i]) > half[i] + (ladder.maxs[i] - ladder.mins[i]) * 0.5) return false;
+		}
+		for (int i = 0; i < 3; i++) {
+			auto& axis = ladder.axes[i];
+			double reach = ladder.extents[i] + std::abs(axis[0]) * half[0] + std::abs(axis[1]) * half[1] + std::abs(axis[2]) * half[2];
+			if (std::abs(DotProduct(delta, axis)) > reach) return false;
+		}
+		return true;
+	}
+
+	// returns -1 if the box doesn't touch any ladder
+	// the grid cells are grown by the box's horizontal size, so only the cell the box's center is in needs looking at
+	int FindLadder(const NyaVec3Double& origin, const NyaVec3Double& mins, const NyaVec3Double& maxs) {
+		auto center = origin + (mins + maxs) * 0.5;
+		auto half = (maxs - mins) * 0.5;
+		double reach = 0;
+		for (int i = 0; i < 3; i++) {
+			if (i != UP) reach = std::max(reach, half[i]);
+		}
+		if (!ladderGrid.bBuilt || ladderGrid.revision != nLadderRevision || ladderGrid.margin < reach) {
+			ladderGrid.Build(aLadders, nLadderRevision, fLadderCellSize, reach);
+		}
+		return ladderGrid.Find(center, [&center, &half](int id) {
+			return IsTouchingLadder(aLadders[id], center, half);
+		});
+	}
+
+	// field by field for replay logs, in movement units like the water volumes
+	void SerializeLadders(std::vector<uint8_t>& out) {
+		auto add = [&out](const void* data, size_t size) {
+			out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		};
+
+		uint32_t count = aLadders.size();
+		add(&count, sizeof(count));
+		for (auto& ladder : aLadders) {
+			add(&ladder.center, sizeof(ladder.center));
+			add(ladder.axes, sizeof(ladder.axes));
+			add(ladder.extents, sizeof(ladder.extents));
+			add(&ladder.mins, sizeof(ladder.mins));
+			add(&ladder.maxs, sizeof(ladder.maxs));
+			add(&ladder.bActive, sizeof(ladder.bActive));
+		}
+	}
+
+	bool DeserializeLadders(const uint8_t* data, size_t size) {
+		auto end = data + size;
+		auto get = [&data, end](void* out, size_t size) {
+			if ((size_t)(end - data) < size) return false;
+			memcpy(out, data, size);
+			data += size;
+			return true;
+		};
+
+		const size_t ladderSize = sizeof(tLadder::center) + sizeof(tLadder::axes) + sizeof(tLadder::extents) + sizeof(tLadder::mins) + sizeof(tLadder::maxs) + sizeof(tLadder::bActive);
+		uint32_t count;
+		if (!get(&count, sizeof(count))) return false;
+		if (size != sizeof(count) + count * ladderSize) return false;
+		std::vector<tLadder> ladders(count);
+		for (auto& ladder : ladders) {
+			if (!get(&ladder.center, sizeof(ladder.center)) || !get(ladder.axes, sizeof(ladder.axes))) return false;
+			if (!get(ladder.extents, sizeof(ladder.extents))) return false;
+			if (!get(&ladder.mins, sizeof(ladder.mins)) || !get(&ladder.maxs, sizeof(ladder.maxs))) return false;
+			if (!get(&ladder.bActive, sizeof(ladder.bActive))) return false;
+		}
+		aLadders = std::move(ladders);
+		nLadderRevision++;
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,277 @@
+#ifndef _WIN32
+#include <ucontext.h>
+#endif
+
+// lockstep stepping of several player contexts, for servers running every client through one library instance
+// each context's Process runs on a fiber of its own, a hull trace parks the fiber instead of calling the host
+// once every fiber is parked or done all of the parked traces go to PM_PlayerTraceBatch in one call, then they all carry on
+// a frame of any number of players then takes about as many host calls as the busiest player's frame on its own
+// the players come out exactly as if Process had been called on each context in turn, the frame budget is held while stepping
+// off unless the host turns it on with SetLockstepBatching, it only pays off when the batch goes to an asynchronous collider
+// every context needs a fiber stack, and every hull trace is two fiber switches, which on linux are a sigprocmask syscall each
+// with an in-process collider the bench runs 64 players about 3x slower like this than one after the other
+namespace FreemanAPI {
+	const int LOCKSTEP_STACK_SIZE = 256 * 1024;
+
+	FREEMANAPI_THREAD_LOCAL bool bLockstepBatching = false;
+
+	struct tLockstepFiber {
+#ifdef _WIN32
+		void* handle = nullptr;
+#else
+		ucontext_t context;
+		std::vector<uint8_t> stack;
+#endif
+		int contextId = 0;
+		bool done = false;
+		FreemanHullTrace request; // the trace it's parked on
+		pmtrace_t trace;
+		uint64_t batchTicks = 0; // its share of the batch call, counted as its own time in the latency stats
+
+		// what Process keeps in globals over a frame, swapped in and out with the fiber
+		tGameCallbacks callbacks;
+		tGameCallbacks inputEventCallbacks;
+		std::vector<tEntityVelocity> entityVelocities;
+		FreemanInputFrame sliceInput = {};
+		const FreemanInputFrame* bufferedInput = nullptr;
+		bool onLadder = false;
+		double budgetFrameStart = 0;
+		uint64_t latencyPausedTicks = 0;
+	};
+
+	FREEMANAPI_THREAD_LOCAL std::vector<tLockstepFiber*> aLockstepFibers; // kept around so the stacks are only allocated once
+	FREEMANAPI_THREAD_LOCAL tLockstepFiber* pLockstepFiber = nullptr; // the one running, null on the scheduler
+	FREEMANAPI_THREAD_LOCAL double fLockstepDelta = 0;
+#ifdef _WIN32
+	FREEMANAPI_THREAD_LOCAL void* pLockstepScheduler = nullptr;
+#else
+	FREEMANAPI_THREAD_LOCAL ucontext_t lockstepScheduler;
+#endif
+
+	void SwitchToLockstepScheduler() {
+#ifdef _WIN32
+		SwitchToFiber(pLockstepScheduler);
+#else
+		swapcontext(&pLockstepFiber->context, &lockstepScheduler);
+#endif
+	}
+
+	// never returns, a finished fiber waits there for the next step to pick it up again
+#ifdef _WIN32
+	void WINAPI LockstepFiberMain(void*) {
+#else
+	void LockstepFiberMain() {
+#endif
+		while (true) {
+			Process(fLockstepDelta);
+			pLockstepFiber->done = true;
+			SwitchToLockstepScheduler();
+		}
+	}
+
+	// stands in for the host's PM_PlayerTrace while stepping, the scheduler fills in the trace before switching back
+	pmtrace_t* LockstepPM_PlayerTrace(const double* start, const double* end) {
+		auto fiber = pLockstepFiber;
+		auto& request = fiber->request;
+		auto hull = GetPlayerHullID();
+		for (int i = 0; i < 3; i++) {
+			request.start[i] = start[i];
+			request.end[i] = end[i];
+			request.mins[i] = pmove->player_mins[hull][i];
+			request.maxs[i] = pmove->player_maxs[hull][i];
+		}
+		request.context = fiber->contextId;
+		auto parked = GetLatencyTicks();
+		SwitchToLockstepScheduler();
+		nLatencyPausedTicks += GetLatencyTicks() - parked - fiber->batchTicks;
+		return &fiber->trace;
+	}
+
+	tLockstepFiber* CreateLockstepFiber() {
+		auto fiber = new tLockstepFiber;
+#ifdef _WIN32
+		fiber->handle = CreateFiber(LOCKSTEP_STACK_SIZE, LockstepFiberMain, nullptr);
+		if (!fiber->handle) {
+			delete fiber;
+			return nullptr;
+		}
+#else
+		fiber->stack.resize(LOCKSTEP_STACK_SIZE);
+		getcontext(&fiber->context);
+		fiber->context.uc_stack.ss_sp = fiber->stack.data();
+		fiber->context.uc_stack.ss_size = fiber->stack.size();
+		fiber->context.uc_link = nullptr;
+		makecontext(&fiber->context, LockstepFiberMain, 0);
+#endif
+		return fiber;
+	}
+
+	// frees the fibers when the thread that made them exits, they're all parked between frames by then
+	struct tLockstepCleanup {
+		~tLockstepCleanup() {
+			for (auto fiber : aLockstepFibers) {
+#ifdef _WIN32
+				DeleteFiber(fiber->handle);
+#endif
+				delete fiber;
+			}
+			aLockstepFibers.clear();
+		}
+	};
+
+	bool ReserveLockstepFibers(int count) {
+		// constructed after aLockstepFibers so it's destroyed before it
+		static FREEMANAPI_THREAD_LOCAL tLockstepCleanup cleanup;
+		while ((int)aLockstepFibers.size() < count) {
+			auto fiber = CreateLockstepFiber();
+			if (!fiber) return false;
+			aLockstepFibers.push_back(fiber);
+		}
+		return true;
+	}
+
+	// swaps the per frame globals with the fiber's copies, the same call puts them in and takes them back out
+	void SwapLockstepState(tLockstepFiber* fiber) {
+		tGameCallbacks callbacks;
+		callbacks.Save();
+		fiber->callbacks.Restore();
+		fiber->callbacks = callbacks;
+		std::swap(inputEventCallbacks, fiber->inputEventCallbacks);
+		std::swap(aEntityVelocities, fiber->entityVelocities);
+		std::swap(sliceInput, fiber->sliceInput);
+		std::swap(pBufferedInput, fiber->bufferedInput);
+		std::swap(bOnLadder, fiber->onLadder);
+		std::swap(fBudgetFrameStart, fiber->budgetFrameStart);
+		std::swap(nLatencyPausedTicks, fiber->latencyPausedTicks);
+	}
+
+	// runs the fiber until it parks on a trace or finishes its frame
+	void RunLockstepFiber(tLockstepFiber* fiber) {
+		SetContext(fiber->contextId);
+		SwapLockstepState(fiber);
+		pLockstepFiber = fiber;
+#ifdef _WIN32
+		SwitchToFiber(fiber->handle);
+#else
+		swapcontext(&lockstepScheduler, &fiber->context);
+#endif
+		pLockstepFiber = nullptr;
+		SwapLockstepState(fiber);
+	}
+
+	void ProcessContextsInTurn(const int* ids, int numIds, double delta) {
+		for (int i = 0; i < numIds; i++) {
+			SetContext(ids[i]);
+			Process(delta);
+		}
+	}
+
+	// one frame of every listed context, returns how many PM_PlayerTraceBatch calls it took, -1 if the ids aren't valid
+	// without SetLockstepBatching, or without both PM_PlayerTrace and PM_PlayerTraceBatch from the host, they're processed one after the other
+	// the host's callbacks can tell whose frame they're being called for with GetContextID, the current context is put back after
+	int StepContexts(const int* ids, int numIds, double delta) {
+		// replays log one player's calls in the order they happened, interleaved players would scramble them
+		// and a host callback stepping the contexts again from inside a step would run fibers that are already running
+		if (IsRecordingReplay() || replayReader.IsActive() || pLockstepFiber) return -1;
+
+		GetContext();
+		for (int i = 0; i < numIds; i++) {
+			if (ids[i] < 0 || ids[i] >= (int)aContexts.size() || !aContexts[ids[i]]) return -1;
+			for (int j = 0; j < i; j++) {
+				if (ids[j] == ids[i]) return -1;
+			}
+		}
+
+		FREEMANAPI_TIMELINE_SCOPE("StepContexts");
+		int hostContext = GetContextID();
+		if (!bLockstepBatching || !EXT_PM_PlayerTrace || !EXT_PM_PlayerTraceBatch || numIds < 2 || !ReserveLockstepFibers(numIds)) {
+			ProcessContextsInTurn(ids, numIds, delta);
+			SetContext(hostContext);
+			return 0;
+		}
+
+#ifdef _WIN32
+		// the host may already be running on a fiber of its own, then that's left as it is
+		pLockstepScheduler = ConvertThreadToFiber(nullptr);
+		bool convertedThread = pLockstepScheduler != nullptr;
+		if (!convertedThread && GetLastError() == ERROR_ALREADY_FIBER) pLockstepScheduler = GetCurrentFiber();
+		if (!pLockstepScheduler) {
+			ProcessContextsInTurn(ids, numIds, delta);
+			SetContext(hostContext);
+			return 0;
+		}
+#endif
+
+		tGameCallbacks hostCallbacks;
+		hostCallbacks.Save();
+		auto callbacks = hostCallbacks;
+		callbacks.PM_PlayerTrace = LockstepPM_PlayerTrace;
+		callbacks.PM_PlayerTraceBatch = nullptr; // the fibers' traces get batched across the players instead
+		// point rays fall back to PM_PlayerTrace, those are traced into a shared batch that can't wait for the others
+		if (!callbacks.PointRaytrace) callbacks.PointRaytrace = hostCallbacks.PM_PlayerTrace;
+
+		// a fiber's frame time includes the time it spent waiting on the others, the budget would only see all of them together
+		// so it's held, every context keeps the quality level it came in with
+		auto budgetHeld = bBudgetHeld;
+		bBudgetHeld = true;
+
+		for (int i = 0; i < numIds; i++) {
+			auto fiber = aLockstepFibers[i];
+			fiber->contextId = ids[i];
+			fiber->done = false;
+			fiber->callbacks = callbacks;
+			fiber->entityVelocities.clear();
+			fiber->bufferedInput = nullptr;
+			fiber->latencyPausedTicks = nLatencyPausedTicks;
+		}
+		fLockstepDelta = delta;
+
+		static FREEMANAPI_THREAD_LOCAL std::vector<tLockstepFiber*> parked;
+		static FREEMANAPI_THREAD_LOCAL std::vector<FreemanHullTrace> requests;
+		static FREEMANAPI_THREAD_LOCAL std::vector<pmtrace_t> traces;
+		int numBatches = 0;
+		int numRunning = numIds;
+		while (numRunning) {
+			parked.clear();
+			requests.clear();
+			for (int i = 0; i < numIds; i++) {
+				auto fiber = aLockstepFibers[i];
+				if (fiber->done) continue;
+
+				RunLockstepFiber(fiber);
+				if (fiber->done) {
+					numRunning--;
+					continue;
+				}
+				parked.push_back(fiber);
+				requests.push_back(fiber->request);
+			}
+			if (requests.empty()) continue;
+
+			traces.resize(requests.size());
+			for (int i = 0; i < (int)traces.size(); i++) {
+				auto& trace = traces[i];
+				trace.Default();
+				trace.endpos = { requests[i].end[0], requests[i].end[1], requests[i].end[2] };
+			}
+			auto batchStart = GetLatencyTicks();
+			{
+				FREEMANAPI_TIMELINE_SCOPE("EXT_PM_PlayerTraceBatch");
+				hostCallbacks.PM_PlayerTraceBatch(requests.data(), requests.size(), traces.data());
+			}
+			auto batchTicks = (GetLatencyTicks() - batchStart) / requests.size();
+			numBatches++;
+			for (int i = 0; i < (int)parked.size(); i++) {
+				parked[i]->trace = traces[i];
+				parked[i]->batchTicks = batchTicks;
+			}
+		}
+
+		bBudgetHeld = budgetHeld;
+#ifdef _WIN32
+		if (convertedThread) ConvertFiberToThread();
+#endif
+		SetContext(hostContext);
+		return numBatches;
+	}
+}
\ No newline at end of file
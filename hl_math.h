@@ -1,7 +1,7 @@
 // HL math and unit conversions
 namespace FreemanAPI {
-	double fUnitsConversion = 0.0254;
-	NyaVec3Double vXYZUnitsMult = {1,1,1};
+	FREEMANAPI_THREAD_LOCAL double fUnitsConversion = 0.0254;
+	FREEMANAPI_THREAD_LOCAL NyaVec3Double vXYZUnitsMult = {1,1,1};
 
 	inline double UnitsToMeters(double f) {
 		return f * fUnitsConversion;
@@ -19,6 +19,13 @@ namespace FreemanAPI {
 		cross[1] = v1[2]*v2[0] - v1[0]*v2[2];
 		cross[2] = v1[0]*v2[1] - v1[1]*v2[0];
 	}
+	inline NyaVec3Double CrossProduct(const NyaVec3Double& v1, const NyaVec3Double& v2) {
+		NyaVec3Double cross;
+		cross[0] = v1[1]*v2[2] - v1[2]*v2[1];
+		cross[1] = v1[2]*v2[0] - v1[0]*v2[2];
+		cross[2] = v1[0]*v2[1] - v1[1]*v2[0];
+		return cross;
+	}
 	inline void VectorSubtract(const NyaVec3Double& a, const NyaVec3Double& b, NyaVec3Double& c) {
 		c[0]=a[0]-b[0];
 		c[1]=a[1]-b[1];
@@ -68,6 +75,12 @@ namespace FreemanAPI {
 		return (3 * valueSquared) - (valueDoubled * valueSquared);
 	}
 
+	// rows through the members, there is no NyaVec3 object inside the matrix for a cast pointer to read so the optimizer may ignore Rotate's writes
+	inline NyaVec3Double GetMatrixRow(const NyaMat4x4& mat, int row) {
+		auto& v = row == 0 ? mat.x : (row == 1 ? mat.y : mat.z);
+		return {v.x, v.y, v.z};
+	}
+
 	void AngleVectors(const NyaVec3Double& angles, NyaVec3Double& fwd, NyaVec3Double& right, NyaVec3Double& up) {
 		auto anglesRad = angles * (std::numbers::pi / 180.0);
 		anglesRad[PITCH] *= -1;
@@ -75,16 +88,9 @@ namespace FreemanAPI {
 		auto mat = NyaMat4x4();
 		mat.Rotate(NyaVec3(anglesRad[1], anglesRad[2], anglesRad[0]));
 
-		// this is disgusting.
-		fwd.x = (*(NyaVec3*)&mat[FORWARD*4]).x;
-		fwd.y = (*(NyaVec3*)&mat[FORWARD*4]).y;
-		fwd.z = (*(NyaVec3*)&mat[FORWARD*4]).z;
-		right.x = mat.x.x;
-		right.y = mat.x.y;
-		right.z = mat.x.z;
-		up.x = (*(NyaVec3*)&mat[UP*4]).x;
-		up.y = (*(NyaVec3*)&mat[UP*4]).y;
-		up.z = (*(NyaVec3*)&mat[UP*4]).z;
+		fwd = GetMatrixRow(mat, FORWARD);
+		right = GetMatrixRow(mat, 0);
+		up = GetMatrixRow(mat, UP);
 	}
 
 	void AngleVectors(const NyaVec3Double& angles, NyaVec3Double& fwd) {
@@ -0,0 +1,211 @@
+// compact player state for replication
+// the state is quantized to plain ints, then delta encoded against a baseline the receiver already has
+// each player is a change bit, a mask of the fields that changed and then only those deltas, bit packed
+// the delta passes run over flat int arrays for every player at once so the compiler can vectorize them
+namespace FreemanAPI {
+	enum {
+		NET_ORIGIN_X,
+		NET_ORIGIN_Y,
+		NET_ORIGIN_Z,
+		NET_VELOCITY_X,
+		NET_VELOCITY_Y,
+		NET_VELOCITY_Z,
+		NET_ANGLE_PITCH,
+		NET_ANGLE_YAW,
+		NET_ANGLE_ROLL,
+		NET_FLAGS,
+		NET_MOVETYPE,
+		NET_ONGROUND,
+		NET_DUCK_BITS,		// m_bDucked, m_bDucking, m_bInDuckJump, bInDuckHL1, usehull
+		NET_DUCK_TIME,		// ms
+		NET_DUCK_JUMP_TIME,	// ms
+		NET_JUMP_TIME,		// ms
+		NUM_NET_FIELDS
+	};
+	static_assert(NUM_NET_FIELDS == sizeof(FreemanNetState::values) / sizeof(int32_t));
+
+	// both ends have to agree on these
+	FREEMANAPI_THREAD_LOCAL double fNetOriginPrecision = 1.0 / 32.0; // units
+	FREEMANAPI_THREAD_LOCAL double fNetVelocityPrecision = 1.0 / 16.0; // units per second
+	FREEMANAPI_THREAD_LOCAL int nNetAngleBits = 16;
+
+	int32_t QuantizeNetValue(double value, double precision) {
+		return (int32_t)std::round(value / precision);
+	}
+
+	int32_t QuantizeNetAngle(double angle) {
+		auto steps = (int64_t)std::round(angle * (1ll << nNetAngleBits) / 360.0);
+		return steps & ((1ll << nNetAngleBits) - 1);
+	}
+
+	double DequantizeNetAngle(int32_t value) {
+		// sign extend so pitch comes back as -89 and not 271
+		int shift = 32 - nNetAngleBits;
+		int32_t steps = (int32_t)((uint32_t)value << shift) >> shift;
+		return steps * 360.0 / (1ll << nNetAngleBits);
+	}
+
+	void GetNetState(FreemanNetState* out) {
+		auto values = out->values;
+		for (int i = 0; i < 3; i++) {
+			values[NET_ORIGIN_X + i] = QuantizeNetValue(pmove->origin[i], fNetOriginPrecision);
+			values[NET_VELOCITY_X + i] = QuantizeNetValue(pmove->velocity[i], fNetVelocityPrecision);
+		}
+		values[NET_ANGLE_PITCH] = QuantizeNetAngle(pmove->angles[PITCH]);
+		values[NET_ANGLE_YAW] = QuantizeNetAngle(pmove->angles[YAW]);
+		values[NET_ANGLE_ROLL] = QuantizeNetAngle(pmove->angles[ROLL]);
+		values[NET_FLAGS] = pmove->flags;
+		values[NET_MOVETYPE] = pmove->movetype;
+		values[NET_ONGROUND] = pmove->onground;
+		values[NET_DUCK_BITS] = pmove->m_bDucked | (pmove->m_bDucking << 1) | (pmove->m_bInDuckJump << 2) | (pmove->bInDuckHL1 << 3) | (pmove->usehull << 4);
+		values[NET_DUCK_TIME] = std::lround(pmove->flDuckTime);
+		values[NET_DUCK_JUMP_TIME] = std::lround(pmove->m_flDuckJumpTime);
+		values[NET_JUMP_TIME] = std::lround(pmove->m_flJumpTime);
+	}
+
+	// only the replicated fields are touched, everything else in the context is left as it was
+	void SetNetState(const FreemanNetState* in) {
+		auto values = in->values;
+		for (int i = 0; i < 3; i++) {
+			pmove->origin[i] = values[NET_ORIGIN_X + i] * fNetOriginPrecision;
+			pmove->velocity[i] = values[NET_VELOCITY_X + i] * fNetVelocityPrecision;
+		}
+		pmove->angles[PITCH] = DequantizeNetAngle(values[NET_ANGLE_PITCH]);
+		pmove->angles[YAW] = DequantizeNetAngle(values[NET_ANGLE_YAW]);
+		pmove->angles[ROLL] = DequantizeNetAngle(values[NET_ANGLE_ROLL]);
+		pmove->flags = values[NET_FLAGS];
+		pmove->movetype = values[NET_MOVETYPE];
+		pmove->onground = values[NET_ONGROUND];
+		int duckBits = values[NET_DUCK_BITS];
+		pmove->m_bDucked = duckBits & 1;
+		pmove->m_bDucking = (duckBits >> 1) & 1;
+		pmove->m_bInDuckJump = (duckBits >> 2) & 1;
+		pmove->bInDuckHL1 = (duckBits >> 3) & 1;
+		pmove->usehull = duckBits >> 4;
+		pmove->flDuckTime = values[NET_DUCK_TIME];
+		pmove->m_flDuckJumpTime = values[NET_DUCK_JUMP_TIME];
+		pmove->m_flJumpTime = values[NET_JUMP_TIME];
+	}
+
+	struct tBitWriter {
+		uint8_t* out;
+		size_t size;
+		size_t pos = 0;
+		uint64_t bits = 0;
+		int numBits = 0;
+		bool bOverflow = false;
+
+		void Write(uint32_t value, int count) {
+			bits |= (uint64_t)value << numBits;
+			numBits += count;
+			while (numBits >= 8) {
+				if (pos < size) out[pos] = bits & 0xFF;
+				else bOverflow = true;
+				pos++;
+				bits >>= 8;
+				numBits -= 8;
+			}
+		}
+
+		void Flush() {
+			if (numBits > 0) Write(0, 8 - numBits);
+		}
+	};
+
+	struct tBitReader {
+		const uint8_t* in;
+		size_t size;
+		size_t pos = 0;
+		uint64_t bits = 0;
+		int numBits = 0;
+		bool bOverflow = false;
+
+		uint32_t Read(int count) {
+			while (numBits < count) {
+				if (pos < size) bits |= (uint64_t)in[pos] << numBits;
+				else bOverflow = true;
+				pos++;
+				numBits += 8;
+			}
+			auto value = (uint32_t)(bits & ((1ull << count) - 1));
+			bits >>= count;
+			numBits -= count;
+			return value;
+		}
+	};
+
+	// deltas are zigzagged and sent as a 2 bit size class followed by 4, 8, 16 or 32 bits
+	const int aNetDeltaBits[4] = { 4, 8, 16, 32 };
+
+	void WriteNetDelta(tBitWriter& writer, uint32_t zigzag) {
+		int sizeClass = zigzag < (1u << 4) ? 0 : zigzag < (1u << 8) ? 1 : zigzag < (1u << 16) ? 2 : 3;
+		writer.Write(sizeClass, 2);
+		writer.Write(zigzag, aNetDeltaBits[sizeClass]);
+	}
+
+	uint32_t ReadNetDelta(tBitReader& reader) {
+		return reader.Read(aNetDeltaBits[reader.Read(2)]);
+	}
+
+	// baselines can be null to send everything against zero, returns the bytes written or -1 if out was too small
+	int EncodeNetStates(const FreemanNetState* states, const FreemanNetState* baselines, int numPlayers, uint8_t* out, int outSize) {
+		static FREEMANAPI_THREAD_LOCAL std::vector<uint32_t> deltas;
+		deltas.resize(numPlayers * NUM_NET_FIELDS);
+
+		// flat passes over every field of every player, no branches, these vectorize
+		auto current = &states[0].values[0];
+		auto base = baselines ? &baselines[0].values[0] : nullptr;
+		int numValues = numPlayers * NUM_NET_FIELDS;
+		if (base) {
+			for (int i = 0; i < numValues; i++) {
+				int32_t delta = (int32_t)((uint32_t)current[i] - (uint32_t)base[i]);
+				deltas[i] = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+			}
+		}
+		else {
+			for (int i = 0; i < numValues; i++) {
+				deltas[i] = ((uint32_t)current[i] << 1) ^ (uint32_t)(current[i] >> 31);
+			}
+		}
+
+		tBitWriter writer = { out, (size_t)outSize };
+		for (int player = 0; player < numPlayers; player++) {
+			auto playerDeltas = &deltas[player * NUM_NET_FIELDS];
+			uint32_t mask = 0;
+			for (int i = 0; i < NUM_NET_FIELDS; i++) {
+				mask |= (playerDeltas[i] != 0) << i;
+			}
+
+			writer.Write(mask != 0, 1);
+			if (!mask) continue;
+			writer.Write(mask, NUM_NET_FIELDS);
+			for (int i = 0; i < NUM_NET_FIELDS; i++) {
+				if (mask & (1 << i)) WriteNetDelta(writer, playerDeltas[i]);
+			}
+		}
+		writer.Flush();
+		if (writer.bOverflow) return -1;
+		return writer.pos;
+	}
+
+	// returns the bytes read or -1 if the data ran out, out can be the same array as baselines
+	int DecodeNetStates(const uint8_t* in, int inSize, const FreemanNetState* baselines, int numPlayers, FreemanNetState* out) {
+		tBitReader reader = { in, (size_t)inSize };
+		for (int player = 0; player < numPlayers; player++) {
+			auto values = out[player].values;
+			if (baselines) memmove(values, baselines[player].values, sizeof(baselines[player].values));
+			else memset(values, 0, sizeof(out[player].values));
+
+			if (!reader.Read(1)) continue;
+			uint32_t mask = reader.Read(NUM_NET_FIELDS);
+			for (int i = 0; i < NUM_NET_FIELDS; i++) {
+				if (!(mask & (1 << i))) continue;
+				uint32_t zigzag = ReadNetDelta(reader);
+				int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+				values[i] = (int32_t)((uint32_t)values[i] + (uint32_t)delta);
+			}
+		}
+		if (reader.bOverflow) return -1;
+		return reader.pos - reader.numBits / 8;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <chrono>
+
+// runtime stats and timing
+// define FREEMANAPI_NO_STATS to compile out all of the hot path counters, timers and timeline events
+namespace FreemanAPI {
+	FREEMANAPI_THREAD_LOCAL FreemanStats stats; // the current context's, see SetContext
+	FREEMANAPI_THREAD_LOCAL bool bStatsPerFrame = false; // reset most stats at the start of every frame instead of accumulating, see ResetFrameStats
+
+	// monotonic time in microseconds, only meaningful as a difference
+	inline double GetProfileMicros() {
+		using namespace std::chrono;
+		return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	struct tProfileScope {
+		double& total;
+		double start;
+
+		tProfileScope(double& out) : total(out), start(GetProfileMicros()) {}
+		~tProfileScope() {
+			total += GetProfileMicros() - start;
+		}
+	};
+
+	void ResetStats() {
+		stats.Default();
+	}
+
+	// what SetStatsPerFrame resets, the frame budget counters keep counting since they'd only ever read 0 or 1 over a single frame
+	void ResetFrameStats() {
+		auto budget = stats;
+		stats.Default();
+		stats.numFrames = budget.numFrames;
+		stats.numBudgetOverruns = budget.numBudgetOverruns;
+		stats.numBudgetDegrades = budget.numBudgetDegrades;
+		stats.numBudgetRestores = budget.numBudgetRestores;
+		stats.budgetQualityLevel = budget.budgetQualityLevel;
+		stats.lastFrameMicros = budget.lastFrameMicros;
+		stats.maxFrameMicros = budget.maxFrameMicros;
+	}
+}
+
+#ifndef FREEMANAPI_NO_STATS
+#define FREEMANAPI_STAT_INC(name) (FreemanAPI::stats.name++)
+#define FREEMANAPI_STAT_ADD(name, value) (FreemanAPI::stats.name += (value))
+#define FREEMANAPI_STAT_TIME(name) FreemanAPI::tProfileScope _statScope_##name(FreemanAPI::stats.name)
+#else
+#define FREEMANAPI_STAT_INC(name) ((void)0)
+#define FREEMANAPI_STAT_ADD(name, value) ((void)0)
+#define FREEMANAPI_STAT_TIME(name) ((void)0)
+#endif
\ No newline at end of file
@@ -0,0 +1,625 @@
+#include <cstdio>
+
+// binary recording of everything the host feeds into the simulation, for deterministic offline replay
+// a log is a header followed by records, each record is a tag, a varint mask of the fields that changed since the last
+// record with the same tag, and then only those fields, so steady input and repeated traces cost a couple bytes each
+namespace FreemanAPI {
+	const uint32_t REPLAY_MAGIC = 0x504D5246; // "FRMP"
+	// bumped whenever an older log would desync
+	// 2: player state version 2 in the state records
+	//    walk moves reuse the direct move trace, older logs have one trace too many
+	//    the point raytrace fallback sweep casts a different set of rays
+	//    adaptive collision density and a new config field
+	//    floor and ceiling probes go straight down and up
+	//    Reset arms the stuck check, the first substep after it traces once more
+	//    input event frames poll the dead flag with the rest of the input and log the substeps that set it up again
+	const uint32_t REPLAY_VERSION = 2;
+
+	enum {
+		REPLAY_END,
+		REPLAY_FRAME,
+		REPLAY_RESET,
+		REPLAY_CONFIG,
+		REPLAY_STATE,
+		REPLAY_STEPS,
+		REPLAY_OUTPUT,
+		REPLAY_DEAD,
+		REPLAY_POSITION,
+		REPLAY_VELOCITY,
+		REPLAY_VIEWANGLE,
+		REPLAY_MOVE_LEFTRIGHT,
+		REPLAY_MOVE_FWDBACK,
+		REPLAY_MOVE_UPDOWN,
+		REPLAY_MOVE_JUMP,
+		REPLAY_MOVE_DUCK,
+		REPLAY_MOVE_RUN,
+		REPLAY_MOVE_USE,
+		REPLAY_POINTCONTENTS,
+		REPLAY_POINTRAYTRACE,
+		REPLAY_PLAYERTRACE,
+		REPLAY_PLAYERTRACEDOWN,
+		REPLAY_STEPHEIGHT,
+		REPLAY_WATER,
+		REPLAY_WATERSURFACE,
+		REPLAY_LADDERS,
+		REPLAY_ENTITYVELOCITY,
+		REPLAY_INPUTEVENTS,
+		NUM_REPLAY_TAGS
+	};
+
+	// field layout of each record, d = double, f = float, i = int
+	// config, state, water and ladders are blobs and don't use this
+	const char* aReplayLayouts[NUM_REPLAY_TAGS] = {
+		"",				// end
+		"dii",			// frame: delta, budget quality level, movetype
+		"ii",			// reset: random seed, default movetype
+		"",				// config
+		"",				// state
+		"ii",			// steps: substep count, budget quality level
+		"ddddddddd",	// output: origin, velocity, angles
+		"i",			// dead
+		"ddd",			// position
+		"ddd",			// velocity
+		"ddd",			// view angle
+		"f",			// move left/right
+		"f",			// move forward/back
+		"f",			// move up/down
+		"i",			// jump
+		"i",			// duck
+		"i",			// run
+		"i",			// use
+		"i",			// point contents
+		"ifddddddfii",	// point raytrace
+		"ifddddddfii",	// player trace
+		"ifddddddfii",	// player trace down
+		"f",			// step height
+		"",				// water volumes
+		"di",			// water surface: height, contents
+		"",				// ladders
+		"iddddddddd",	// entity velocity: moving, origin, velocity, angular velocity
+		"i",			// input events: the types the host sends, the frame's input is set up before every substep
+	};
+
+	struct tReplayRecord {
+		static const int MAX_FIELDS = 16;
+		uint64_t values[MAX_FIELDS] = {};
+		int numValues = 0;
+
+		void AddDouble(double value) {
+			memcpy(&values[numValues++], &value, sizeof(value));
+		}
+		void AddFloat(float value) {
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			values[numValues++] = bits;
+		}
+		void AddInt(int64_t value) {
+			values[numValues++] = value;
+		}
+		void AddVector(const NyaVec3Double& value) {
+			AddDouble(value.x);
+			AddDouble(value.y);
+			AddDouble(value.z);
+		}
+
+		double GetDouble(int i) const {
+			double value;
+			memcpy(&value, &values[i], sizeof(value));
+			return value;
+		}
+		float GetFloat(int i) const {
+			uint32_t bits = values[i];
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+		int64_t GetInt(int i) const {
+			return values[i];
+		}
+		NyaVec3Double GetVector(int i) const {
+			return { GetDouble(i), GetDouble(i + 1), GetDouble(i + 2) };
+		}
+	};
+
+	enum {
+		REPLAY_TRACE_ALLSOLID = 1 << 0,
+		REPLAY_TRACE_STARTSOLID = 1 << 1,
+		REPLAY_TRACE_INOPEN = 1 << 2,
+		REPLAY_TRACE_INWATER = 1 << 3,
+		REPLAY_TRACE_ENDPOS_IS_END = 1 << 4, // endpos is exactly the requested end, not stored
+	};
+
+	// settings that change the result of a frame, written up front and again whenever they change
+	void SerializeReplayConfig(std::vector<uint8_t>& out) {
+		auto add = [&out](const void* data, size_t size) {
+			out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		};
+
+		for (auto vec : { &aBehaviorConfig, &aAdvancedConfig, &aCVarConfigHL1, &aCVarConfigHL2 }) {
+			for (auto& value : *vec) {
+				if (value.bValue) add(value.bValue, sizeof(*value.bValue));
+				if (value.iValue) add(value.iValue, sizeof(*value.iValue));
+				if (value.fValue) add(value.fValue, sizeof(*value.fValue));
+			}
+		}
+		add(&bAutoHop, sizeof(bAutoHop));
+		add(&bConvertUnits, sizeof(bConvertUnits));
+		add(&fUnitsConversion, sizeof(fUnitsConversion));
+		add(&vXYZUnitsMult, sizeof(vXYZUnitsMult));
+		add(&NyaMat4x4::bZUp, sizeof(NyaMat4x4::bZUp));
+		add(&PITCH, sizeof(PITCH));
+		add(&YAW, sizeof(YAW));
+		add(&ROLL, sizeof(ROLL));
+		add(&FORWARD, sizeof(FORWARD));
+		add(&UP, sizeof(UP));
+	}
+
+	bool DeserializeReplayConfig(const uint8_t* data, size_t size) {
+		std::vector<uint8_t> current;
+		SerializeReplayConfig(current);
+		if (current.size() != size) return false;
+
+		auto get = [&data](void* out, size_t size) {
+			memcpy(out, data, size);
+			data += size;
+		};
+
+		for (auto vec : { &aBehaviorConfig, &aAdvancedConfig, &aCVarConfigHL1, &aCVarConfigHL2 }) {
+			for (auto& value : *vec) {
+				if (value.bValue) get(value.bValue, sizeof(*value.bValue));
+				if (value.iValue) get(value.iValue, sizeof(*value.iValue));
+				if (value.fValue) get(value.fValue, sizeof(*value.fValue));
+			}
+		}
+		get(&bAutoHop, sizeof(bAutoHop));
+		get(&bConvertUnits, sizeof(bConvertUnits));
+		get(&fUnitsConversion, sizeof(fUnitsConversion));
+		get(&vXYZUnitsMult, sizeof(vXYZUnitsMult));
+		// bZUp is shared by every thread, the replay farm can't have one worker flipping it under the others
+		// so with thread contexts a recording made with the other axis fails instead
+		bool zUp;
+		get(&zUp, sizeof(zUp));
+		if (zUp != NyaMat4x4::bZUp) {
+#ifdef FREEMANAPI_THREAD_CONTEXTS
+			return false;
+#else
+			NyaMat4x4::bZUp = zUp;
+#endif
+		}
+		get(&PITCH, sizeof(PITCH));
+		get(&YAW, sizeof(YAW));
+		get(&ROLL, sizeof(ROLL));
+		get(&FORWARD, sizeof(FORWARD));
+		get(&UP, sizeof(UP));
+		return true;
+	}
+
+	// bumped whenever a field is added, moved or removed
+	// 2: flLastPlaneNormal, flSimTime, colLod, iLadder, iBaseEnt, vecBaseEntVelocity, flCarriedYaw,
+	//    bStuckCheck, iStuckOffset, flStuckTime, flBobTime, flBob and flBobLastTime removed
+	const uint32_t PLAYER_STATE_VERSION = 2;
+
+	// every field of the player in a fixed order, saved states then don't depend on how the struct is laid out
+	// new fields go at the end, a set of layout changes shares one version bump and is listed under it
+	template<typename T>
+	void VisitPlayerStateFields(playermove_s* state, T& field) {
+		auto vec = [&field](NyaVec3Double& value) {
+			field(&value.x, sizeof(value.x));
+			field(&value.y, sizeof(value.y));
+			field(&value.z, sizeof(value.z));
+		};
+
+		field(&state->frametime, sizeof(state->frametime));
+		vec(state->forward);
+		vec(state->right);
+		vec(state->up);
+		vec(state->origin);
+		vec(state->angles);
+		vec(state->oldangles);
+		vec(state->velocity);
+		vec(state->movedir);
+		vec(state->basevelocity);
+		vec(state->view_ofs);
+		field(&state->flDuckTime, sizeof(state->flDuckTime));
+		field(&state->bInDuckHL1, sizeof(state->bInDuckHL1));
+		field(&state->flTimeStepSound, sizeof(state->flTimeStepSound));
+		field(&state->iStepLeft, sizeof(state->iStepLeft));
+		field(&state->flFallVelocity, sizeof(state->flFallVelocity));
+		vec(state->punchangle);
+		field(&state->flSwimTime, sizeof(state->flSwimTime));
+		field(&state->iSkipStep, sizeof(state->iSkipStep));
+		field(&state->random.state, sizeof(state->random.state));
+		field(&state->bLastSprinting, sizeof(state->bLastSprinting));
+		field(&state->bLastHL2, sizeof(state->bLastHL2));
+		field(&state->flags, sizeof(state->flags));
+		field(&state->usehull, sizeof(state->usehull));
+		field(&state->gravity, sizeof(state->gravity));
+		field(&state->friction, sizeof(state->friction));
+		field(&state->oldbuttons, sizeof(state->oldbuttons));
+		field(&state->waterjumptime, sizeof(state->waterjumptime));
+		field(&state->dead, sizeof(state->dead));
+		field(&state->movetype, sizeof(state->movetype));
+		field(&state->onground, sizeof(state->onground));
+		field(&state->waterlevel, sizeof(state->waterlevel));
+		field(&state->watertype, sizeof(state->watertype));
+		field(&state->oldwaterlevel, sizeof(state->oldwaterlevel));
+		field(&state->chtexturetype, sizeof(state->chtexturetype));
+		field(&state->maxspeed, sizeof(state->maxspeed));
+		field(&state->clientmaxspeed, sizeof(state->clientmaxspeed));
+		field(&state->cmd.msec, sizeof(state->cmd.msec));
+		vec(state->cmd.viewangles);
+		field(&state->cmd.forwardmove, sizeof(state->cmd.forwardmove));
+		field(&state->cmd.sidemove, sizeof(state->cmd.sidemove));
+		field(&state->cmd.upmove, sizeof(state->cmd.upmove));
+		field(&state->cmd.buttons, sizeof(state->cmd.buttons));
+		for (auto& mins : state->player_mins) {
+			vec(mins);
+		}
+		for (auto& maxs : state->player_maxs) {
+			vec(maxs);
+		}
+		field(&state->m_bDucked, sizeof(state->m_bDucked));
+		field(&state->m_bDucking, sizeof(state->m_bDucking));
+		field(&state->m_bInDuckJump, sizeof(state->m_bInDuckJump));
+		field(&state->m_flDuckJumpTime, sizeof(state->m_flDuckJumpTime));
+		field(&state->m_flJumpTime, sizeof(state->m_flJumpTime));
+		field(&state->m_iSpeedCropped, sizeof(state->m_iSpeedCropped));
+		field(&state->m_bIsSprinting, sizeof(state->m_bIsSprinting));
+		field(&state->m_bAllowAutoMovement, sizeof(state->m_bAllowAutoMovement));
+		vec(state->m_vecPunchAngleVel);
+		field(&state->flLastPlaneNormal, sizeof(state->flLastPlaneNormal));
+		field(&state->flSimTime, sizeof(state->flSimTime));
+		for (auto& lod : state->colLod) {
+			field(&lod.density, sizeof(lod.density));
+			field(&lod.calmQueries, sizeof(lod.calmQueries));
+		}
+		field(&state->iLadder, sizeof(state->iLadder));
+		field(&state->iBaseEnt, sizeof(state->iBaseEnt));
+		vec(state->vecBaseEntVelocity);
+		field(&state->flCarriedYaw, sizeof(state->flCarriedYaw));
+		field(&state->bStuckCheck, sizeof(state->bStuckCheck));
+		field(&state->iStuckOffset, sizeof(state->iStuckOffset));
+		field(&state->flStuckTime, sizeof(state->flStuckTime));
+	}
+
+	// what SerializePlayerState writes, the same for every player of this build
+	size_t GetPlayerStateSize() {
+		size_t size = sizeof(PLAYER_STATE_VERSION);
+		auto count = [&size](const void*, size_t fieldSize) { size += fieldSize; };
+		VisitPlayerStateFields(pmove, count);
+		return size;
+	}
+
+	void SerializePlayerState(std::vector<uint8_t>& out) {
+		auto add = [&out](const void* data, size_t size) {
+			out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		};
+
+		add(&PLAYER_STATE_VERSION, sizeof(PLAYER_STATE_VERSION));
+		VisitPlayerStateFields(pmove, add);
+	}
+
+	// leaves the player alone unless the data is the same version and exactly the right size
+	bool DeserializePlayerState(const uint8_t* data, size_t size) {
+		auto end = data + size;
+		bool ok = true;
+		auto get = [&data, end, &ok](void* out, size_t size) {
+			if ((size_t)(end - data) < size) {
+				ok = false;
+				return;
+			}
+			memcpy(out, data, size);
+			data += size;
+		};
+
+		uint32_t version = 0;
+		get(&version, sizeof(version));
+		if (!ok || version != PLAYER_STATE_VERSION) return false;
+
+		auto state = *pmove;
+		VisitPlayerStateFields(&state, get);
+		if (!ok || data != end) return false;
+		*pmove = state;
+		return true;
+	}
+
+	struct tReplayWriter {
+		FILE* file = nullptr;
+		std::vector<uint8_t> buffer;
+		tReplayRecord aLast[NUM_REPLAY_TAGS];
+		std::vector<uint8_t> lastConfig;
+		uint32_t lastWaterRevision = 0;
+		uint32_t lastLadderRevision = 0;
+
+		bool IsActive() const {
+			return file != nullptr;
+		}
+
+		void PutByte(uint8_t value) {
+			buffer.push_back(value);
+		}
+		void PutRaw(const void* data, size_t size) {
+			buffer.insert(buffer.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		}
+		void PutVarint(uint64_t value) {
+			while (value >= 0x80) {
+				PutByte((value & 0x7F) | 0x80);
+				value >>= 7;
+			}
+			PutByte(value);
+		}
+		void PutBlob(int tag, const void* data, size_t size) {
+			PutByte(tag);
+			PutVarint(size);
+			PutRaw(data, size);
+		}
+
+		void Flush() {
+			if (!file || buffer.empty()) return;
+			fwrite(buffer.data(), 1, buffer.size(), file);
+			buffer.clear();
+		}
+
+		void Write(int tag, const tReplayRecord& record) {
+			auto layout = aReplayLayouts[tag];
+			auto& last = aLast[tag];
+
+			uint64_t mask = 0;
+			for (int i = 0; layout[i]; i++) {
+				if (record.values[i] != last.values[i]) mask |= 1ull << i;
+			}
+
+			PutByte(tag);
+			PutVarint(mask);
+			for (int i = 0; layout[i]; i++) {
+				if (!(mask & (1ull << i))) continue;
+
+				switch (layout[i]) {
+					case 'd':
+						PutRaw(&record.values[i], 8);
+						break;
+					case 'f':
+						PutRaw(&record.values[i], 4);
+						break;
+					case 'i': {
+						auto value = (int64_t)record.values[i];
+						PutVarint((uint64_t)(value << 1) ^ (uint64_t)(value >> 63)); // zigzag
+					} break;
+				}
+			}
+			last = record;
+
+			if (buffer.size() >= 65536) Flush();
+		}
+
+		void WriteTrace(int tag, const pmtrace_t* trace, const NyaVec3Double* end) {
+			bool endposIsEnd = !memcmp(&trace->endpos, end, sizeof(*end));
+
+			int flags = 0;
+			if (trace->allsolid) flags |= REPLAY_TRACE_ALLSOLID;
+			if (trace->startsolid) flags |= REPLAY_TRACE_STARTSOLID;
+			if (trace->inopen) flags |= REPLAY_TRACE_INOPEN;
+			if (trace->inwater) flags |= REPLAY_TRACE_INWATER;
+			if (endposIsEnd) flags |= REPLAY_TRACE_ENDPOS_IS_END;
+
+			tReplayRecord record;
+			record.AddInt(flags);
+			record.AddFloat(trace->fraction);
+			// keep the last endpos if it's not needed, so it doesn't count as a change
+			if (endposIsEnd) record.AddVector(aLast[tag].GetVector(2));
+			else record.AddVector(trace->endpos);
+			record.AddVector(trace->plane.normal);
+			record.AddFloat(trace->plane.dist);
+			record.AddInt(trace->ent);
+			record.AddInt(trace->surfaceId);
+			Write(tag, record);
+		}
+
+		void WriteConfigIfChanged() {
+			std::vector<uint8_t> config;
+			SerializeReplayConfig(config);
+			if (config == lastConfig) return;
+			PutBlob(REPLAY_CONFIG, config.data(), config.size());
+			lastConfig = std::move(config);
+		}
+
+		bool Start(const char* path, uint32_t callbackMask) {
+			Stop();
+
+			file = fopen(path, "wb");
+			if (!file) return false;
+
+			for (auto& last : aLast) {
+				last = {};
+			}
+			lastConfig.clear();
+			lastWaterRevision = 0;
+			lastLadderRevision = 0;
+
+			PutRaw(&REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+			PutRaw(&REPLAY_VERSION, sizeof(REPLAY_VERSION));
+			PutRaw(&callbackMask, sizeof(callbackMask));
+			WriteConfigIfChanged();
+			std::vector<uint8_t> state;
+			SerializePlayerState(state);
+			PutBlob(REPLAY_STATE, state.data(), state.size());
+			return true;
+		}
+
+		void Stop() {
+			if (!file) return;
+			PutByte(REPLAY_END);
+			Flush();
+			fclose(file);
+			file = nullptr;
+		}
+	};
+	FREEMANAPI_THREAD_LOCAL tReplayWriter replayWriter;
+
+	struct tReplayReader {
+		std::vector<uint8_t> file; // only used when reading from a path
+		const uint8_t* data = nullptr;
+		size_t dataSize = 0;
+		size_t pos = 0;
+		bool bActive = false;
+		bool bDesynced = false;
+		uint32_t callbackMask = 0;
+		uint32_t numFrames = 0;
+		uint32_t numOutputMismatches = 0;
+		int firstOutputMismatch = -1;
+		tReplayRecord aLast[NUM_REPLAY_TAGS];
+
+		bool IsActive() const {
+			return bActive;
+		}
+
+		bool HasCallback(int tag) const {
+			return (callbackMask & (1 << tag)) != 0;
+		}
+
+		bool GetRaw(void* out, size_t size) {
+			if (pos + size > dataSize) {
+				bDesynced = true;
+				memset(out, 0, size);
+				return false;
+			}
+			memcpy(out, data + pos, size);
+			pos += size;
+			return true;
+		}
+		uint64_t GetVarint() {
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				uint8_t byte;
+				if (!GetRaw(&byte, 1)) return 0;
+				value |= (uint64_t)(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) break;
+			}
+			return value;
+		}
+
+		int PeekTag() const {
+			if (pos >= dataSize) return REPLAY_END;
+			return data[pos];
+		}
+
+		// returns the last values for this tag if the log doesn't match what the simulation is asking for
+		const tReplayRecord& Read(int tag) {
+			auto& last = aLast[tag];
+			if (bDesynced) return last;
+			if (PeekTag() != tag) {
+				bDesynced = true;
+				return last;
+			}
+			pos++;
+
+			auto layout = aReplayLayouts[tag];
+			uint64_t mask = GetVarint();
+			for (int i = 0; layout[i]; i++) {
+				if (!(mask & (1ull << i))) continue;
+
+				switch (layout[i]) {
+					case 'd':
+						GetRaw(&last.values[i], 8);
+						break;
+					case 'f': {
+						uint32_t bits;
+						GetRaw(&bits, 4);
+						last.values[i] = bits;
+					} break;
+					case 'i': {
+						uint64_t value = GetVarint();
+						last.values[i] = (value >> 1) ^ -(int64_t)(value & 1);
+					} break;
+				}
+			}
+			return last;
+		}
+
+		void ReadTrace(int tag, pmtrace_t* out, const NyaVec3Double* end) {
+			auto& record = Read(tag);
+			int flags = record.GetInt(0);
+			out->Default();
+			out->allsolid = (flags & REPLAY_TRACE_ALLSOLID) != 0;
+			out->startsolid = (flags & REPLAY_TRACE_STARTSOLID) != 0;
+			out->inopen = (flags & REPLAY_TRACE_INOPEN) != 0;
+			out->inwater = (flags & REPLAY_TRACE_INWATER) != 0;
+			out->fraction = record.GetFloat(1);
+			out->endpos = (flags & REPLAY_TRACE_ENDPOS_IS_END) ? *end : record.GetVector(2);
+			out->plane.normal = record.GetVector(5);
+			out->plane.dist = record.GetFloat(8);
+			out->ent = record.GetInt(9);
+			out->surfaceId = record.GetInt(10);
+		}
+
+		bool ReadBlob(int tag, std::vector<uint8_t>& out) {
+			if (PeekTag() != tag) return false;
+			pos++;
+			out.resize(GetVarint());
+			return GetRaw(out.data(), out.size());
+		}
+
+		bool Open(const char* path) {
+			auto handle = fopen(path, "rb");
+			if (!handle) return false;
+			fseek(handle, 0, SEEK_END);
+			file.resize(ftell(handle));
+			fseek(handle, 0, SEEK_SET);
+			bool ok = fread(file.data(), 1, file.size(), handle) == file.size();
+			fclose(handle);
+			if (!ok) return false;
+			return Open(file.data(), file.size());
+		}
+
+		// reads straight out of memory the caller owns, e.g. a mapped file, it has to outlive the replay
+		bool Open(const uint8_t* buffer, size_t bufferSize) {
+			data = buffer;
+			dataSize = bufferSize;
+			pos = 0;
+			bDesynced = false;
+			numFrames = 0;
+			numOutputMismatches = 0;
+			firstOutputMismatch = -1;
+			for (auto& last : aLast) {
+				last = {};
+			}
+
+			uint32_t magic, version;
+			GetRaw(&magic, sizeof(magic));
+			GetRaw(&version, sizeof(version));
+			GetRaw(&callbackMask, sizeof(callbackMask));
+			return magic == REPLAY_MAGIC && version == REPLAY_VERSION && !bDesynced;
+		}
+	};
+	FREEMANAPI_THREAD_LOCAL tReplayReader replayReader;
+
+	inline bool IsRecordingReplay() {
+		return replayWriter.IsActive();
+	}
+
+	void RecordReplayInt(int tag, int64_t value) {
+		if (!IsRecordingReplay()) return;
+		tReplayRecord record;
+		record.AddInt(value);
+		replayWriter.Write(tag, record);
+	}
+
+	void RecordReplayFloat(int tag, float value) {
+		if (!IsRecordingReplay()) return;
+		tReplayRecord record;
+		record.AddFloat(value);
+		replayWriter.Write(tag, record);
+	}
+
+	void RecordReplayVector(int tag, const NyaVec3Double& value) {
+		if (!IsRecordingReplay()) return;
+		tReplayRecord record;
+		record.AddVector(value);
+		replayWriter.Write(tag, record);
+	}
+
+	void RecordReplayTrace(int tag, const pmtrace_t* trace, const NyaVec3Double* end) {
+		if (!IsRecordingReplay()) return;
+		replayWriter.WriteTrace(tag, trace, end);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+// opt-in simulation thread
+// the library ticks the player at a fixed rate on its own thread instead of inside the game's frame
+// the game pushes input through a lock-free queue and reads back the last two ticks, interpolated for the current time
+// while it's running the query callbacks (traces, point contents, player dead) are called from the sim thread,
+// the output callbacks, sounds and fall damage are only ever called on the game thread from PollSimThread
+// nothing else may touch the player or the settings until StopSimThread, the exports that would return early while it's running
+namespace FreemanAPI {
+	// single producer single consumer ring, one thread pushes and one thread pops, no locks
+	template<typename T, uint32_t N>
+	struct tSPSCQueue {
+		static_assert((N & (N - 1)) == 0, "tSPSCQueue size has to be a power of 2");
+
+		T items[N];
+		std::atomic<uint32_t> head = 0; // only written by the consumer
+		std::atomic<uint32_t> tail = 0; // only written by the producer
+
+		bool Push(const T& item) {
+			auto pos = tail.load(std::memory_order_relaxed);
+			if (pos - head.load(std::memory_order_acquire) >= N) return false;
+			items[pos % N] = item;
+			tail.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Pop(T& out) {
+			auto pos = head.load(std::memory_order_relaxed);
+			if (pos == tail.load(std::memory_order_acquire)) return false;
+			out = items[pos % N];
+			head.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		void Clear() {
+			head = 0;
+			tail = 0;
+		}
+	};
+
+	enum {
+		SIM_EVENT_SOUND,
+		SIM_EVENT_FALL_DAMAGE,
+	};
+
+	struct tSimEvent {
+		int type;
+		float value;
+		char path[64];
+	};
+
+	// the last two ticks, published together so the game always interpolates between a matching pair
+	struct tSimOutput {
+		FreemanSimFrame previous;
+		FreemanSimFrame current;
+		double publishMicros;
+	};
+
+	// none of this can be thread local, it's what the two threads share
+	std::thread simThread;
+	std::atomic<bool> bSimThreadRunning = false;
+	double fSimTickTime = 1.0 / 60.0;
+	tGameCallbacks simHostCallbacks; // what the host had set, restored on stop
+	HMODULE hSimModule = nullptr; // the reference the sim thread holds on the library
+
+	tSPSCQueue<FreemanInputFrame, 256> simInputQueue;
+	tSPSCQueue<tSimEvent, 256> simEventQueue;
+
+	// triple buffer, the sim thread always has a slot to write into and the game thread always has a whole one to read
+	const int SIM_SLOT_NEW = 4;
+	tSimOutput aSimOutputs[3];
+	int nSimWriteSlot = 0; // sim thread only
+	int nSimReadSlot = 1; // game thread only
+	std::atomic<int> nSimMiddleSlot = 2;
+
+	// sim thread only
+	FreemanInputFrame simLatestInput;
+	FreemanInputFrame simTickInput;
+	FreemanSimFrame simFrame;
+	FreemanSimFrame simLastFrame;
+
+	void SimGetGamePlayerViewAngle(double* out) {
+		out[0] = simTickInput.viewAngles[0];
+		out[1] = simTickInput.viewAngles[1];
+		out[2] = simTickInput.viewAngles[2];
+	}
+	float SimGetGameMoveLeftRight() { return simTickInput.leftRight; }
+	float SimGetGameMoveFwdBack() { return simTickInput.fwdBack; }
+	float SimGetGameMoveUpDown() { return simTickInput.upDown; }
+	bool SimGetGameMoveJump() { return simTickInput.jump; }
+	bool SimGetGameMoveDuck() { return simTickInput.duck; }
+	bool SimGetGameMoveRun() { return simTickInput.run; }
+	bool SimGetGameMoveUse() { return simTickInput.use; }
+
+	void SimSetGamePlayerPosition(const double* in, const double* inVelocity) {
+		memcpy(simFrame.origin, in, sizeof(simFrame.origin));
+		memcpy(simFrame.velocity, inVelocity, sizeof(simFrame.velocity));
+	}
+	void SimSetGamePlayerPositionRaw(const double* in, const double*) {
+		memcpy(simFrame.originRaw, in, sizeof(simFrame.originRaw));
+	}
+	void SimSetGamePlayerViewPosition(const double* in) {
+		memcpy(simFrame.viewOrigin, in, sizeof(simFrame.viewOrigin));
+	}
+	void SimSetGamePlayerViewAngle(const double* in) {
+		memcpy(simFrame.viewAngles, in, sizeof(simFrame.viewAngles));
+	}
+
+	void SimPlayGameSound(const char* path, float volume) {
+		tSimEvent event;
+		event.type = SIM_EVENT_SOUND;
+		event.value = volume;
+		strncpy(event.path, path, sizeof(event.path) - 1);
+		event.path[sizeof(event.path) - 1] = 0;
+		simEventQueue.Push(event); // dropped if the game stopped polling
+	}
+	void SimOnTakeFallDamage(float dmg) {
+		tSimEvent event;
+		event.type = SIM_EVENT_FALL_DAMAGE;
+		event.value = dmg;
+		event.path[0] = 0;
+		simEventQueue.Push(event);
+	}
+
+	// everything queued since the last tick is merged, the newest input wins but a button held in any of them counts
+	// so a jump tapped between two ticks isn't lost, if nothing was queued the last input is held
+	void UpdateSimTickInput() {
+		FreemanInputFrame input;
+		bool jump = false, duck = false, run = false, use = false;
+		while (simInputQueue.Pop(input)) {
+			simLatestInput = input;
+			jump |= input.jump;
+			duck |= input.duck;
+			run |= input.run;
+			use |= input.use;
+		}
+		simTickInput = simLatestInput;
+		simTickInput.jump |= jump;
+		simTickInput.duck |= duck;
+		simTickInput.run |= run;
+		simTickInput.use |= use;
+	}
+
+	void RunSimTick() {
+		UpdateSimTickInput();
+		Process(fSimTickTime);
+
+		simFrame.time = simLastFrame.time + fSimTickTime;
+		simFrame.tick = simLastFrame.tick + 1;
+		if (simFrame.tick == 1) simLastFrame = simFrame;
+
+		auto& output = aSimOutputs[nSimWriteSlot];
+		output.previous = simLastFrame;
+		output.current = simFrame;
+		output.publishMicros = GetProfileMicros();
+		nSimWriteSlot = nSimMiddleSlot.exchange(nSimWriteSlot | SIM_SLOT_NEW, std::memory_order_acq_rel) & 3;
+		simLastFrame = simFrame;
+	}
+
+	void SimThreadMain() {
+		using namespace std::chrono;
+		auto tickDuration = duration_cast<steady_clock::duration>(duration<double>(fSimTickTime));
+		auto nextTick = steady_clock::now();
+		while (bSimThreadRunning.load(std::memory_order_relaxed)) {
+			RunSimTick();
+
+			// after a long stall (debugger, suspended process) start over instead of running every missed tick back to back
+			nextTick += tickDuration;
+			auto now = steady_clock::now();
+			if (now - nextTick > tickDuration * 8) nextTick = now;
+			std::this_thread::sleep_until(nextTick);
+		}
+	}
+
+	// the host has to promise its query callbacks can be called from another thread, otherwise this refuses to start
+	bool StartSimThread(double tickRate, bool callbacksThreadSafe) {
+#ifdef FREEMANAPI_THREAD_CONTEXTS
+		// the sim thread would get its own blank copy of every setting and callback
+		return false;
+#endif
+		if (bSimThreadRunning || !callbacksThreadSafe || tickRate <= 0) return false;
+
+		fSimTickTime = 1.0 / tickRate;
+		simInputQueue.Clear();
+		simEventQueue.Clear();
+		nSimWriteSlot = 0;
+		nSimReadSlot = 1;
+		nSimMiddleSlot = 2;
+		memset(&simFrame, 0, sizeof(simFrame));
+		memset(&simLastFrame, 0, sizeof(simLastFrame));
+
+		// start from the host's view angles so the player doesn't snap to yaw 0 before the first input arrives
+		memset(&simLatestInput, 0, sizeof(simLatestInput));
+		NyaVec3Double viewAngles;
+		GetGamePlayerViewAngle(&viewAngles);
+		for (int i = 0; i < 3; i++) {
+			simLatestInput.viewAngles[i] = viewAngles[i];
+		}
+
+		simHostCallbacks.Save();
+		tGameCallbacks callbacks = simHostCallbacks;
+		callbacks.GetGamePlayerViewAngle = SimGetGamePlayerViewAngle;
+		callbacks.GetGameMoveLeftRight = SimGetGameMoveLeftRight;
+		callbacks.GetGameMoveFwdBack = SimGetGameMoveFwdBack;
+		callbacks.GetGameMoveUpDown = SimGetGameMoveUpDown;
+		callbacks.GetGameMoveJump = SimGetGameMoveJump;
+		callbacks.GetGameMoveDuck = SimGetGameMoveDuck;
+		callbacks.GetGameMoveRun = SimGetGameMoveRun;
+		callbacks.GetGameMoveUse = SimGetGameMoveUse;
+		callbacks.SetGamePlayerPosition = SimSetGamePlayerPosition;
+		callbacks.SetGamePlayerPositionRaw = SimSetGamePlayerPositionRaw;
+		callbacks.SetGamePlayerViewPosition = SimSetGamePlayerViewPosition;
+		callbacks.SetGamePlayerViewAngle = SimSetGamePlayerViewAngle;
+		callbacks.PlayGameSound = SimPlayGameSound;
+		callbacks.OnTakeFallDamage = SimOnTakeFallDamage;
+		callbacks.Restore();
+
+		// keeps the library loaded while the thread runs, if the host unloaded it first the thread would be running code that's gone
+		GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)&SimThreadMain, &hSimModule);
+
+		bSimThreadRunning = true;
+		simThread = std::thread(SimThreadMain);
+		return true;
+	}
+
+	bool PushSimInput(const FreemanInputFrame* input) {
+		if (!bSimThreadRunning) return false;
+		return simInputQueue.Push(*input);
+	}
+
+	double LerpSimAngle(double a, double b, double t) {
+		double delta = std::remainder(b - a, 360.0);
+		return a + delta * t;
+	}
+
+	void PlaySimEvents() {
+		tSimEvent event;
+		while (simEventQueue.Pop(event)) {
+			if (event.type == SIM_EVENT_SOUND) {
+				if (simHostCallbacks.PlayGameSound) simHostCallbacks.PlayGameSound(event.path, event.value);
+			}
+			else if (event.type == SIM_EVENT_FALL_DAMAGE) {
+				if (simHostCallbacks.OnTakeFallDamage) simHostCallbacks.OnTakeFallDamage(event.value);
+			}
+		}
+	}
+
+	// game thread only, plays what the sim thread queued up and hands the interpolated player to the host
+	// out can be null to only go through the output callbacks, returns false until the first tick is done
+	bool PollSimThread(FreemanSimFrame* out) {
+		if (!bSimThreadRunning) return false;
+		PlaySimEvents();
+
+		if (nSimMiddleSlot.load(std::memory_order_relaxed) & SIM_SLOT_NEW) {
+			nSimReadSlot = nSimMiddleSlot.exchange(nSimReadSlot, std::memory_order_acq_rel) & 3;
+		}
+		auto& output = aSimOutputs[nSimReadSlot];
+		if (!output.current.tick) return false;
+
+		// one tick behind, moving from the previous tick to the current one over the tick after it was published
+		double t = (GetProfileMicros() - output.publishMicros) / (fSimTickTime * 1000000.0);
+		t = std::min(std::max(t, 0.0), 1.0);
+
+		auto& a = output.previous;
+		auto& b = output.current;
+		FreemanSimFrame frame = b;
+		frame.time = std::lerp(a.time, b.time, t);
+		for (int i = 0; i < 3; i++) {
+			frame.origin[i] = std::lerp(a.origin[i], b.origin[i], t);
+			frame.originRaw[i] = std::lerp(a.originRaw[i], b.originRaw[i], t);
+			frame.velocity[i] = std::lerp(a.velocity[i], b.velocity[i], t);
+			frame.viewOrigin[i] = std::lerp(a.viewOrigin[i], b.viewOrigin[i], t);
+			frame.viewAngles[i] = LerpSimAngle(a.viewAngles[i], b.viewAngles[i], t);
+		}
+
+		if (simHostCallbacks.SetGamePlayerPosition) simHostCallbacks.SetGamePlayerPosition(frame.origin, frame.velocity);
+		if (simHostCallbacks.SetGamePlayerPositionRaw) simHostCallbacks.SetGamePlayerPositionRaw(frame.originRaw, frame.velocity);
+		if (simHostCallbacks.SetGamePlayerViewPosition) simHostCallbacks.SetGamePlayerViewPosition(frame.viewOrigin);
+		if (simHostCallbacks.SetGamePlayerViewAngle) simHostCallbacks.SetGamePlayerViewAngle(frame.viewAngles);
+		if (out) *out = frame;
+		return true;
+	}
+
+	void StopSimThread() {
+		if (!bSimThreadRunning) return;
+		bSimThreadRunning = false;
+		simThread.join();
+		simHostCallbacks.Restore();
+		if (hSimModule) FreeLibrary(hSimModule);
+		hSimModule = nullptr;
+
+		// whatever was still queued up is played out
+		PlaySimEvents();
+	}
+
+	// DllMain only, a running sim thread holds a reference to the library so this only gets here with it running on process exit
+	// windows has already ended the thread by then and joining under the loader lock could hang,
+	// but a std::thread that's still joinable calls std::terminate when it's destroyed
+	void DetachSimThread() {
+		if (!simThread.joinable()) return;
+		bSimThreadRunning = false;
+		simThread.detach();
+	}
+}
\ No newline at end of file
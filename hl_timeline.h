@@ -0,0 +1,123 @@
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+
+// timeline recorder, dumps scoped events as chrome/perfetto trace event json
+// each thread writes into its own ring buffer, so recording never takes a lock
+namespace FreemanAPI {
+	struct tTimelineEvent {
+		const char* name;
+		double start;
+		double duration;
+	};
+
+	struct tTimelineBuffer {
+		static constexpr uint32_t SIZE = 65536; // must be a power of two
+		tTimelineEvent events[SIZE];
+		std::atomic<uint32_t> head = 0; // total events written, wraps around the ring, only ever stored by the owning thread
+		std::atomic<uint32_t> tail = 0; // where ClearTimeline last cut it off, events before it aren't dumped
+		int threadId = 0;
+	};
+
+	std::atomic<bool> bTimelineEnabled = false;
+	std::mutex timelineBuffersMutex; // only taken when a thread records its first event or exits, and when clearing or dumping
+	std::vector<tTimelineBuffer*> aTimelineBuffers;
+	int nTimelineThreadId = 0;
+
+	// owns the thread's buffer, when the thread exits it's taken out of the list and freed, along with whatever it recorded
+	struct tTimelineBufferOwner {
+		tTimelineBuffer* buffer = nullptr;
+
+		~tTimelineBufferOwner() {
+			if (!buffer) return;
+
+			std::lock_guard lock(timelineBuffersMutex);
+			for (size_t i = 0; i < aTimelineBuffers.size(); i++) {
+				if (aTimelineBuffers[i] != buffer) continue;
+				aTimelineBuffers.erase(aTimelineBuffers.begin() + i);
+				break;
+			}
+			delete buffer;
+		}
+	};
+	thread_local tTimelineBufferOwner timelineBufferOwner;
+
+	tTimelineBuffer* GetTimelineBuffer() {
+		if (timelineBufferOwner.buffer) return timelineBufferOwner.buffer;
+
+		auto buffer = new tTimelineBuffer;
+		std::lock_guard lock(timelineBuffersMutex);
+		buffer->threadId = ++nTimelineThreadId;
+		aTimelineBuffers.push_back(buffer);
+		timelineBufferOwner.buffer = buffer;
+		return buffer;
+	}
+
+	void AddTimelineEvent(const char* name, double start, double end) {
+		auto buffer = GetTimelineBuffer();
+		auto head = buffer->head.load(std::memory_order_relaxed);
+		auto& event = buffer->events[head & (tTimelineBuffer::SIZE - 1)];
+		event.name = name;
+		event.start = start;
+		event.duration = end - start;
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	struct tTimelineScope {
+		const char* name = nullptr;
+		double start = 0;
+
+		tTimelineScope(const char* eventName) {
+			if (!bTimelineEnabled.load(std::memory_order_relaxed)) return;
+			name = eventName;
+			start = GetProfileMicros();
+		}
+		~tTimelineScope() {
+			if (!name) return;
+			AddTimelineEvent(name, start, GetProfileMicros());
+		}
+	};
+
+	// only moves the tails up, the threads recording keep writing from their own heads without noticing
+	void ClearTimeline() {
+		std::lock_guard lock(timelineBuffersMutex);
+		for (auto& buffer : aTimelineBuffers) {
+			buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+		}
+	}
+
+	// best called between frames, events recorded while dumping may come out torn
+	bool DumpTimeline(const char* path) {
+		if (!path) return false;
+
+		auto file = fopen(path, "w");
+		if (!file) return false;
+
+		std::lock_guard lock(timelineBuffersMutex);
+
+		fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+		bool first = true;
+		for (auto& buffer : aTimelineBuffers) {
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"FreemanAPI %d\"}}", first ? "" : ",\n", buffer->threadId, buffer->threadId);
+			first = false;
+
+			uint32_t head = buffer->head.load(std::memory_order_acquire);
+			uint32_t count = std::min(head - buffer->tail.load(std::memory_order_relaxed), tTimelineBuffer::SIZE);
+			for (uint32_t i = head - count; i != head; i++) {
+				auto& event = buffer->events[i & (tTimelineBuffer::SIZE - 1)];
+				fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.name, buffer->threadId, event.start, event.duration);
+			}
+		}
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		return true;
+	}
+}
+
+#ifndef FREEMANAPI_NO_STATS
+#define FREEMANAPI_TIMELINE_CONCAT2(a, b) a##b
+#define FREEMANAPI_TIMELINE_CONCAT(a, b) FREEMANAPI_TIMELINE_CONCAT2(a, b)
+#define FREEMANAPI_TIMELINE_SCOPE(name) FreemanAPI::tTimelineScope FREEMANAPI_TIMELINE_CONCAT(_timelineScope, __LINE__)(name)
+#else
+#define FREEMANAPI_TIMELINE_SCOPE(name) ((void)0)
+#endif
\ No newline at end of file
@@ -56,7 +56,10 @@ namespace FreemanAPI {
 		//bool footsteps;			// Play footstep sounds
 		float rollangle;
 		float rollspeed;
-	} *movevars = new movevars_s;
+	};
+	// storage lives with the thread so the headless tools don't leak one per worker
+	FREEMANAPI_THREAD_LOCAL movevars_s movevarsStorage;
+	FREEMANAPI_THREAD_LOCAL movevars_s* movevars = &movevarsStorage;
 
 	typedef struct usercmd_s {
 		uint32_t msec;				// Duration in ms of command
@@ -69,6 +72,39 @@ namespace FreemanAPI {
 		unsigned short buttons;		// Attack buttons
 	} usercmd_t;
 
+	// pcg32, small and fully deterministic so identical inputs always give the same step sounds
+	struct tRandom {
+		uint64_t state = 0x853c49e6748fea9bULL;
+
+		void Seed(uint64_t seed) {
+			state = 0;
+			Next();
+			state += seed;
+			Next();
+		}
+
+		uint32_t Next() {
+			uint64_t old = state;
+			state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+			uint32_t xorshifted = ((old >> 18u) ^ old) >> 27u;
+			uint32_t rot = old >> 59u;
+			return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+		}
+	};
+
+	// kinds of point raytrace fallback probe, each picks its own collision density
+	enum {
+		COL_QUERY_FLOOR,
+		COL_QUERY_CEILING,
+		COL_QUERY_HULL,
+		NUM_COL_QUERIES
+	};
+
+	struct tColLod {
+		int density = 0;					// 0 = not picked yet, starts at the full density
+		int calmQueries = 0;				// probes in a row that found nothing nearby
+	};
+
 	struct playermove_s {
 		float frametime;					// Duration of this frame
 		NyaVec3Double forward, right, up;	// Vectors for angles
@@ -95,6 +131,23 @@ namespace FreemanAPI {
 
 		float flSwimTime;
 
+		int iSkipStep = 0;					// for skipping every other wading step sound
+		tRandom random;						// for sound variations
+
+		bool bLastSprinting = false;
+		bool bLastHL2 = true;				// hl2 mode as of the last frame, to detect swaps
+		float flLastPlaneNormal = 0;		// for the debug menu and UpdateColLod
+
+		double flSimTime = 0;				// sum of all simulated substeps, or whatever the host set with SetSimTime
+		tColLod colLod[NUM_COL_QUERIES];	// see GetColDensity
+		int iLadder = -1;					// registered ladder we're climbing, -1 if none
+		int iBaseEnt = -1;					// moving ground entity carrying the player, -1 if none
+		NyaVec3Double vecBaseEntVelocity = {0,0,0};	// its velocity under the player, handed to the player when getting off
+		bool bStuckCheck = true;			// a trace from the player's position started out solid, see PM_CheckStuck
+		int iStuckOffset = -1;				// stuck table entry that got the player out last time
+		double flStuckTime = -INFINITY;		// sim time of the last full pass through the table that found nothing
+		double flCarriedYaw = 0;			// yaw turned by rotating ground entities, added to the host's view angle
+
 		int	flags;							// FL_ONGROUND, FL_DUCKING, etc.
 		int	usehull;						// 0 = regular player hull, 1 = ducked player hull, 2 = point hull
 		float gravity;						// Our current gravity and friction.
@@ -134,5 +187,7 @@ namespace FreemanAPI {
 		bool m_bIsSprinting = false;
 		bool m_bAllowAutoMovement = true;
 		NyaVec3Double m_vecPunchAngleVel = {0,0,0};
-	} *pmove = new playermove_s;
+	};
+	FREEMANAPI_THREAD_LOCAL playermove_s pmoveStorage; // context 0's player, SetContext points pmove at the others
+	FREEMANAPI_THREAD_LOCAL playermove_s* pmove = &pmoveStorage;
 }
\ No newline at end of file
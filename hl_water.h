@@ -0,0 +1,206 @@
+// water volumes registered by the host, so water checks don't need a point contents callback for every probe
+// volumes are boxes, convex hulls (planes plus bounds) or height planes, given in game space and stored in movement units
+// a uniform grid over the two horizontal axes finds the few volumes worth testing, see hl_grid.h
+namespace FreemanAPI {
+	struct tWaterPlane {
+		NyaVec3Double normal;
+		double dist; // inside is dot(normal, point) <= dist
+	};
+
+	struct tWaterVolume {
+		NyaVec3Double mins;
+		NyaVec3Double maxs;
+		std::vector<tWaterPlane> planes; // empty for boxes
+		int contents = CONTENTS_EMPTY; // empty for removed volumes
+
+		bool IsActive() const {
+			return contents != CONTENTS_EMPTY;
+		}
+	};
+
+	FREEMANAPI_THREAD_LOCAL std::vector<tWaterVolume> aWaterVolumes; // indexed by id
+	FREEMANAPI_THREAD_LOCAL uint32_t nWaterRevision = 0; // bumped on every change, replays log the volumes when it moves
+	FREEMANAPI_THREAD_LOCAL double fWaterCellSize = 256; // units, raised when the volumes span too many cells
+
+	const int WATER_MAX_STACKED = 8; // volumes followed upwards when finding the surface
+
+	FREEMANAPI_THREAD_LOCAL tVolumeGrid waterGrid;
+
+	void UpdateWaterGrid() {
+		if (!waterGrid.bBuilt || waterGrid.revision != nWaterRevision) waterGrid.Build(aWaterVolumes, nWaterRevision, fWaterCellSize);
+	}
+
+	int AddWaterVolume(tWaterVolume volume) {
+		if (volume.contents < CONTENTS_LAVA || volume.contents > CONTENTS_WATER) return -1;
+
+		// a flipped axis swaps the bounds
+		for (int i = 0; i < 3; i++) {
+			auto a = volume.mins[i];
+			auto b = volume.maxs[i];
+			volume.mins[i] = std::min(a, b);
+			volume.maxs[i] = std::max(a, b);
+		}
+
+		nWaterRevision++;
+		for (int i = 0; i < (int)aWaterVolumes.size(); i++) {
+			if (aWaterVolumes[i].contents == CONTENTS_EMPTY) {
+				aWaterVolumes[i] = std::move(volume);
+				return i;
+			}
+		}
+		aWaterVolumes.push_back(std::move(volume));
+		return aWaterVolumes.size() - 1;
+	}
+
+	int AddWaterBox(const double* mins, const double* maxs, int contents) {
+		tWaterVolume volume;
+		volume.mins = VolumePointToUnits(mins);
+		volume.maxs = VolumePointToUnits(maxs);
+		volume.contents = contents;
+		return AddWaterVolume(std::move(volume));
+	}
+
+	// planes are 4 doubles each, normal and distance, the inside is where dot(normal, point) <= distance
+	int AddWaterHull(const double* planes, int numPlanes, const double* mins, const double* maxs, int contents) {
+		tWaterVolume volume;
+		for (int i = 0; i < numPlanes; i++) {
+			auto in = &planes[i * 4];
+			tWaterPlane plane;
+			plane.normal = { in[0], in[1], in[2] };
+			plane.dist = in[3];
+			if (bConvertUnits) {
+				plane.normal *= vXYZUnitsMult;
+				plane.dist = MetersToUnits(plane.dist);
+			}
+			volume.planes.push_back(plane);
+		}
+		volume.mins = VolumePointToUnits(mins);
+		volume.maxs = VolumePointToUnits(maxs);
+		volume.contents = contents;
+		return AddWaterVolume(std::move(volume));
+	}
+
+	// everything below the height, for seas and lakes that cover the whole map
+	int AddWaterPlane(double height, int contents) {
+		tWaterVolume volume;
+		tWaterPlane plane;
+		plane.normal = {0,0,0};
+		plane.normal[UP] = 1;
+		plane.dist = height;
+		// the normal stays pointing up in movement space, GetWaterVolumeTop only looks at planes facing up
+		// with the up axis flipped the height is what flips, below it in the game is still below it here
+		if (bConvertUnits) plane.dist = MetersToUnits(plane.dist) * vXYZUnitsMult[UP];
+		volume.planes.push_back(plane);
+		volume.mins = { -INFINITY, -INFINITY, -INFINITY };
+		volume.maxs = { INFINITY, INFINITY, INFINITY };
+		volume.contents = contents;
+		return AddWaterVolume(std::move(volume));
+	}
+
+	void RemoveWaterVolume(int id) {
+		if (id < 0 || id >= (int)aWaterVolumes.size() || aWaterVolumes[id].contents == CONTENTS_EMPTY) return;
+		aWaterVolumes[id] = {};
+		nWaterRevision++;
+	}
+
+	void ClearWaterVolumes() {
+		aWaterVolumes.clear();
+		nWaterRevision++;
+	}
+
+	bool IsInWaterVolume(const tWaterVolume& volume, const NyaVec3Double& point) {
+		for (int i = 0; i < 3; i++) {
+			if (point[i] < volume.mins[i] || point[i] > volume.maxs[i]) return false;
+		}
+		for (auto& plane : volume.planes) {
+			if (DotProduct(plane.normal, point) > plane.dist) return false;
+		}
+		return true;
+	}
+
+	// highest point of the volume straight above the point
+	double GetWaterVolumeTop(const tWaterVolume& volume, const NyaVec3Double& point) {
+		double top = volume.maxs[UP];
+		for (auto& plane : volume.planes) {
+			if (plane.normal[UP] <= 0) continue;
+			top = std::min(top, (plane.dist - DotProduct(plane.normal, point) + plane.normal[UP] * point[UP]) / plane.normal[UP]);
+		}
+		return top;
+	}
+
+	// returns -1 if no volume has the point, ignore skips the volume the surface search is climbing out of
+	int FindWaterVolume(const NyaVec3Double& point, int ignore = -1) {
+		UpdateWaterGrid();
+		return waterGrid.Find(point, [&point, ignore](int id) {
+			return id != ignore && IsInWaterVolume(aWaterVolumes[id], point);
+		});
+	}
+
+	bool HasWaterVolumes() {
+		UpdateWaterGrid();
+		return waterGrid.numVolumes > 0;
+	}
+
+	// contents and the height of the water surface above the point, in movement units
+	// volumes stacked on top of each other count as one body of water
+	bool GetWaterVolumeSurface(const NyaVec3Double& point, int* contents, double* surface) {
+		int id = FindWaterVolume(point);
+		if (id < 0) return false;
+
+		*contents = aWaterVolumes[id].contents;
+		*surface = GetWaterVolumeTop(aWaterVolumes[id], point);
+		for (int i = 0; i < WATER_MAX_STACKED; i++) {
+			auto top = point;
+			top[UP] = *surface;
+			id = FindWaterVolume(top, id);
+			if (id < 0) break;
+			auto above = GetWaterVolumeTop(aWaterVolumes[id], point);
+			if (above <= *surface) break;
+			*surface = above;
+		}
+		return true;
+	}
+
+	// raw copy of the volumes for replay logs, they're already in movement units so the log doesn't depend on the unit settings
+	void SerializeWaterVolumes(std::vector<uint8_t>& out) {
+		auto add = [&out](const void* data, size_t size) {
+			out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		};
+
+		uint32_t count = aWaterVolumes.size();
+		add(&count, sizeof(count));
+		for (auto& volume : aWaterVolumes) {
+			uint32_t numPlanes = volume.planes.size();
+			add(&volume.mins, sizeof(volume.mins));
+			add(&volume.maxs, sizeof(volume.maxs));
+			add(&volume.contents, sizeof(volume.contents));
+			add(&numPlanes, sizeof(numPlanes));
+			if (numPlanes) add(volume.planes.data(), numPlanes * sizeof(tWaterPlane));
+		}
+	}
+
+	bool DeserializeWaterVolumes(const uint8_t* data, size_t size) {
+		auto end = data + size;
+		auto get = [&data, end](void* out, size_t size) {
+			if ((size_t)(end - data) < size) return false;
+			memcpy(out, data, size);
+			data += size;
+			return true;
+		};
+
+		uint32_t count;
+		if (!get(&count, sizeof(count))) return false;
+		std::vector<tWaterVolume> volumes(count);
+		for (auto& volume : volumes) {
+			uint32_t numPlanes;
+			if (!get(&volume.mins, sizeof(volume.mins)) || !get(&volume.maxs, sizeof(volume.maxs))) return false;
+			if (!get(&volume.contents, sizeof(volume.contents)) || !get(&numPlanes, sizeof(numPlanes))) return false;
+			if (numPlanes > (end - data) / sizeof(tWaterPlane)) return false;
+			volume.planes.resize(numPlanes);
+			if (numPlanes && !get(volume.planes.data(), numPlanes * sizeof(tWaterPlane))) return false;
+		}
+		aWaterVolumes = std::move(volumes);
+		nWaterRevision++;
+		return true;
+	}
+}
\ No newline at end of file
@@ -1,8 +1,18 @@
 #include "hl_config.h"
 #include "hl_cvars.h"
 #include "include/hl_consts.h"
+#include "include/hl_stats.h"
 #include "hl_types.h"
 #include "hl_math.h"
+#include "hl_profile.h"
+#include "hl_timeline.h"
+#include "hl_histogram.h"
+#include "hl_replay.h"
+#include "hl_netstate.h"
+#include "hl_context.h"
+#include "hl_grid.h"
+#include "hl_water.h"
+#include "hl_ladder.h"
 #include "hl_game_ext.h"
 
 namespace FreemanAPI {
@@ -67,7 +77,8 @@ namespace FreemanAPI {
 		return out;
 	}
 
-	int nDefaultMoveType = MOVETYPE_WALK;
+	FREEMANAPI_THREAD_LOCAL int nDefaultMoveType = MOVETYPE_WALK;
+	FREEMANAPI_THREAD_LOCAL uint64_t nRandomSeed = 0;
 
 	// export func helpers
 	pmtrace_t PointRaytrace(NyaVec3Double origin, NyaVec3Double end) {
@@ -91,7 +102,64 @@ namespace FreemanAPI {
 		return *trace;
 	}
 
+	// rays that don't depend on each other, collected up front and traced in one go
+	struct tRayBatch {
+		std::vector<NyaVec3Double> starts;
+		std::vector<NyaVec3Double> ends;
+		std::vector<pmtrace_t> traces;
+		std::vector<NyaVec3Double> gameStarts; // in game units
+		std::vector<NyaVec3Double> gameEnds;
+
+		void Clear() {
+			starts.clear();
+			ends.clear();
+		}
+
+		void Add(const NyaVec3Double& start, const NyaVec3Double& end) {
+			starts.push_back(start);
+			ends.push_back(end);
+		}
+
+		void Trace() {
+			int count = starts.size();
+			traces.resize(count);
+			FREEMANAPI_STAT_ADD(numCollisionRays, count);
+			if (!bConvertUnits) {
+				PointRaytraceBatchGame(starts.data(), ends.data(), count, traces.data());
+				return;
+			}
+
+			gameStarts.resize(count);
+			gameEnds.resize(count);
+			for (int i = 0; i < count; i++) {
+				for (int j = 0; j < 3; j++) {
+					gameStarts[i][j] = UnitsToMeters(starts[i][j]);
+					gameEnds[i][j] = UnitsToMeters(ends[i][j]);
+				}
+				gameStarts[i] *= vXYZUnitsMult;
+				gameEnds[i] *= vXYZUnitsMult;
+			}
+			PointRaytraceBatchGame(gameStarts.data(), gameEnds.data(), count, traces.data());
+			for (auto& trace : traces) {
+				for (int j = 0; j < 3; j++) {
+					trace.endpos[j] = MetersToUnits(trace.endpos[j]);
+				}
+				trace.plane.dist = MetersToUnits(trace.plane.dist);
+				trace.endpos *= vXYZUnitsMult;
+				trace.plane.normal *= vXYZUnitsMult;
+			}
+		}
+	};
+	FREEMANAPI_THREAD_LOCAL tRayBatch rayBatch; // kept around so the buffers are only allocated once
+
+	// a trace out of where the player is started inside something, PM_CheckStuck has a look next substep
+	// traces from anywhere else are probes for spots the player might move to, those can be solid without anything being wrong
+	void FlagStuckCheck(const NyaVec3Double& start) {
+		if (start.x == pmove->origin.x && start.y == pmove->origin.y && start.z == pmove->origin.z) pmove->bStuckCheck = true;
+	}
+
 	pmtrace_t PM_PlayerTrace(NyaVec3Double origin, NyaVec3Double end) {
+		auto start = origin;
 		if (bConvertUnits) {
 			for (int i = 0; i < 3; i++) {
 				origin[i] = UnitsToMeters(origin[i]);
@@ -109,10 +177,52 @@ namespace FreemanAPI {
 			trace->endpos *= vXYZUnitsMult;
 			trace->plane.normal *= vXYZUnitsMult;
 		}
+		if (trace->startsolid || trace->allsolid) FlagStuckCheck(start);
 		return *trace;
 	}
 
+	// PM_PlayerTrace for several moves of the current hull at once, through the host's batch callback
+	void PM_PlayerTraceBatch(const NyaVec3Double* starts, const NyaVec3Double* ends, int count, pmtrace_t* out) {
+		static FREEMANAPI_THREAD_LOCAL std::vector<FreemanHullTrace> requests; // kept around so it's only allocated once
+		requests.resize(count);
+		auto hull = GetPlayerHullID();
+		for (int i = 0; i < count; i++) {
+			auto origin = starts[i];
+			auto end = ends[i];
+			if (bConvertUnits) {
+				for (int j = 0; j < 3; j++) {
+					origin[j] = UnitsToMeters(origin[j]);
+					end[j] = UnitsToMeters(end[j]);
+				}
+				origin *= vXYZUnitsMult;
+				end *= vXYZUnitsMult;
+			}
+			auto& request = requests[i];
+			for (int j = 0; j < 3; j++) {
+				request.start[j] = origin[j];
+				request.end[j] = end[j];
+				request.mins[j] = pmove->player_mins[hull][j];
+				request.maxs[j] = pmove->player_maxs[hull][j];
+			}
+			request.context = GetContextID();
+		}
+		PM_PlayerTraceBatchGame(requests.data(), count, out);
+		for (int i = 0; i < count; i++) {
+			auto trace = &out[i];
+			if (bConvertUnits) {
+				for (int j = 0; j < 3; j++) {
+					trace->endpos[j] = MetersToUnits(trace->endpos[j]);
+				}
+				trace->plane.dist = MetersToUnits(trace->plane.dist);
+				trace->endpos *= vXYZUnitsMult;
+				trace->plane.normal *= vXYZUnitsMult;
+			}
+			if (trace->startsolid || trace->allsolid) FlagStuckCheck(starts[i]);
+		}
+	}
+
 	pmtrace_t PM_PlayerTraceDown(NyaVec3Double origin, NyaVec3Double end) {
+		auto start = origin;
 		if (bConvertUnits) {
 			for (int i = 0; i < 3; i++) {
 				origin[i] = UnitsToMeters(origin[i]);
@@ -130,10 +240,44 @@ namespace FreemanAPI {
 			trace->endpos *= vXYZUnitsMult;
 			trace->plane.normal *= vXYZUnitsMult;
 		}
+		if (trace->startsolid || trace->allsolid) FlagStuckCheck(start);
 		return *trace;
 	}
 
-	std::string lastConsoleMsg;
+	// height of whatever blocks a move from origin to dest, above the bottom of the player's box, negative if unknown
+	float GetStepHeight(NyaVec3Double origin, NyaVec3Double dest) {
+		if (!EXT_GetStepHeight) return STEP_HEIGHT_UNKNOWN;
+
+		if (bConvertUnits) {
+			for (int i = 0; i < 3; i++) {
+				origin[i] = UnitsToMeters(origin[i]);
+				dest[i] = UnitsToMeters(dest[i]);
+			}
+			origin *= vXYZUnitsMult;
+			dest *= vXYZUnitsMult;
+		}
+		// along the game's up axis, so a host with it inverted reports obstacles as negative
+		float height = GetStepHeightGame(&origin, &dest);
+		if (height == STEP_HEIGHT_UNKNOWN) return height; // before the sign flip, or an inverted axis would turn it into a wall
+		if (bConvertUnits) height = MetersToUnits(height) * vXYZUnitsMult[UP];
+		return height;
+	}
+
+	// a trace that's already been done, so a move that would start with the exact same one can skip it
+	struct tKnownTrace {
+		NyaVec3Double start;
+		NyaVec3Double end;
+		pmtrace_t trace;
+
+		bool Matches(const NyaVec3Double& _start, const NyaVec3Double& _end) const {
+			for (int i = 0; i < 3; i++) {
+				if (start[i] != _start[i] || end[i] != _end[i]) return false;
+			}
+			return true;
+		}
+	};
+
+	FREEMANAPI_THREAD_LOCAL std::string lastConsoleMsg;
 
 	// default hullmins
 	static const NyaVec3Double pm_hullmins[4] = {
@@ -167,17 +311,17 @@ namespace FreemanAPI {
 			{  32,  32,  64 },
 	};
 
-	void PM_DropPunchAngle(NyaVec3Double& punchangle) {
+	void PM_DropPunchAngle(NyaVec3Double& punchangle, double frametime) {
 		auto len = VectorNormalize(punchangle);
-		len -= (10.0 + len * 0.5) * pmove->frametime;
+		len -= (10.0 + len * 0.5) * frametime;
 		len = std::max(len, 0.0f);
 		VectorScale(punchangle, len, punchangle);
 	}
 
-	void DecayPunchAngle() {
-		if (pmove->punchangle.LengthSqr() > 0.001 || pmove->punchangle.LengthSqr() > 0.001) {
-			pmove->punchangle += pmove->m_vecPunchAngleVel * pmove->frametime;
-			float damping = 1 - (PUNCH_DAMPING * pmove->frametime);
+	void DecayPunchAngle(double frametime) {
+		if (pmove->punchangle.LengthSqr() > 0.001 || pmove->m_vecPunchAngleVel.LengthSqr() > 0.001) {
+			pmove->punchangle += pmove->m_vecPunchAngleVel * frametime;
+			float damping = 1 - (PUNCH_DAMPING * frametime);
 
 			if (damping < 0) {
 				damping = 0;
@@ -186,7 +330,7 @@ namespace FreemanAPI {
 
 			// torsional spring
 			// UNDONE: Per-axis spring constant?
-			float springForceMagnitude = PUNCH_SPRING_CONSTANT * pmove->frametime;
+			float springForceMagnitude = PUNCH_SPRING_CONSTANT * frametime;
 			if (springForceMagnitude < 0.f) springForceMagnitude = 0.f;
 			if (springForceMagnitude > 2.f) springForceMagnitude = 2.f;
 			pmove->m_vecPunchAngleVel -= pmove->punchangle * springForceMagnitude;
@@ -205,9 +349,14 @@ namespace FreemanAPI {
 		}
 	}
 
+	// random number in [0, count), seeded per player so a replay of the same inputs plays the same sounds
+	int PM_RandomInt(int count) {
+		return pmove->random.Next() % count;
+	}
+
 	void PlaySwimSound() {
 		if (bHL2Mode) {
-			switch (rand() % 8) {
+			switch (PM_RandomInt(8)) {
 				case 0:
 					PlayGameSound("player/footsteps/wade1.wav", 1);
 					break;
@@ -235,7 +384,7 @@ namespace FreemanAPI {
 			}
 		}
 		else {
-			switch (rand() % 4) {
+			switch (PM_RandomInt(4)) {
 				case 0:
 					PlayGameSound("player/pl_wade1.wav", 1);
 					break;
@@ -282,25 +431,23 @@ namespace FreemanAPI {
 		return side * sign;
 	}
 
-	float V_CalcBob() {
+	// elapsed is the simulated time since the last call, instead of the client time check
+	float V_CalcBob(tViewState& view, double elapsed) {
 		auto cl_bobcycle = bHL2Mode ? CVar_HL2::cl_bobcycle : CVar_HL1::cl_bobcycle;
 		auto cl_bobup = bHL2Mode ? CVar_HL2::cl_bobup : CVar_HL1::cl_bobup;
 		auto cl_bob = bHL2Mode ? CVar_HL2::cl_bob : CVar_HL1::cl_bob;
 
-		static double bobtime;
-		static float bob;
+		auto& bobtime = view.bobTime;
+		auto& bob = view.bob;
 		float cycle;
-		static float lasttime;
 		NyaVec3Double vel;
 
-		if (pmove->onground == -1 || pmove->cmd.msec == lasttime) {
+		if (pmove->onground == -1 || elapsed <= 0) {
 			// just use old value
 			return bob;
 		}
 
-		lasttime = pmove->cmd.msec;
-
-		bobtime += pmove->frametime;
+		bobtime += elapsed;
 		cycle = bobtime - (int)(bobtime / cl_bobcycle) * cl_bobcycle;
 		cycle /= cl_bobcycle;
 
@@ -323,6 +470,27 @@ namespace FreemanAPI {
 		return bob;
 	}
 
+	// the view only effects, kept out of the substeps and run when the host wants the eye position or angles
+	// bob advances by the simulated time since the last run, so skipped frames catch up in one go
+	// punch and roll stay in the substeps, PM_PlayerMove's AngleVectors uses pmove->angles as in pm_shared
+	tViewState& CalcView() {
+		auto& view = GetContext()->view;
+		if (!view.bDirty) return view;
+		view.bDirty = false;
+		FREEMANAPI_STAT_INC(numViewCalcs);
+		FREEMANAPI_TIMELINE_SCOPE("CalcView");
+
+		// the host can move the sim time backwards, that's a fresh start and not a negative step
+		double elapsed = std::max(pmove->flSimTime - view.simTime, 0.0);
+		view.simTime = pmove->flSimTime;
+
+		view.origin = pmove->origin + pmove->view_ofs;
+		view.origin[UP] += V_CalcBob(view, elapsed);
+
+		view.angles = pmove->angles;
+		return view;
+	}
+
 	void PM_CheckParamters() {
 		float spd;
 		float maxspeed;
@@ -357,10 +525,10 @@ namespace FreemanAPI {
 		}
 
 		if (bHL2Mode) {
-			DecayPunchAngle();
+			DecayPunchAngle(pmove->frametime);
 		}
 		else {
-			PM_DropPunchAngle(pmove->punchangle);
+			PM_DropPunchAngle(pmove->punchangle, pmove->frametime);
 		}
 
 		// Take angles from command.
@@ -433,8 +601,67 @@ namespace FreemanAPI {
 		}
 	}
 
-	int nPhysicsSteps = 4;
-	int nColDensity = 2;
+	FREEMANAPI_THREAD_LOCAL int nPhysicsSteps = 4;
+	FREEMANAPI_THREAD_LOCAL int nColDensity = 2;
+	FREEMANAPI_THREAD_LOCAL int nFrameBudgetMicros = 0; // 0 = no budget
+
+	// frame budget state, collision quality gets stepped down when a frame threatens to go over budget
+	const int BUDGET_MAX_QUALITY_LEVEL = 2;
+	const int BUDGET_RESTORE_FRAMES = 30; // frames spent well under budget before stepping quality back up
+	// the quality level and calm frame count are kept per context, see hl_context.h
+	FREEMANAPI_THREAD_LOCAL double fBudgetFrameStart = 0;
+	FREEMANAPI_THREAD_LOCAL bool bBudgetHeld = false; // quality level stays where it is, see Rollback
+
+	// adaptive collision density, every kind of fallback probe picks its own density from what it found last time
+	// nColDensity is the most it'll use, near geometry or at speed, out in the open it drops down to 1
+	FREEMANAPI_THREAD_LOCAL bool bAdaptiveColDensity = true;
+	FREEMANAPI_THREAD_LOCAL float fColLodMargin = 16; // units, anything closer than this counts as nearby
+	FREEMANAPI_THREAD_LOCAL float fColLodFastSpeed = 400; // units per second, always full density above this
+	const int COL_LOD_CALM_QUERIES = 16; // probes in a row that found nothing nearby before the density steps down once
+
+	int GetColDensity(int query) {
+		int density = std::max(nColDensity, 1);
+		if (bAdaptiveColDensity && pmove->colLod[query].density) {
+			density = std::min(pmove->colLod[query].density, density);
+		}
+		if (nBudgetQualityLevel >= 2) return 1;
+		if (nBudgetQualityLevel >= 1) return std::max(density - 1, 1);
+		return density;
+	}
+
+	// steps straight back up to full density, but only steps down after a while so it doesn't flicker at the edge of the margin
+	// standing on a slope always counts as nearby, a coarse probe is what lets the hull sink into ramps
+	void UpdateColLod(int query, bool nearby) {
+		if (!bAdaptiveColDensity) return;
+
+		auto& lod = pmove->colLod[query];
+		int maxDensity = std::max(nColDensity, 1);
+		bool onSlope = pmove->onground != -1 && pmove->flLastPlaneNormal < 0.999;
+		if (nearby || onSlope || !lod.density || pmove->velocity.length() > fColLodFastSpeed) {
+			lod.density = maxDensity;
+			lod.calmQueries = 0;
+		}
+		else if (lod.density > maxDensity) {
+			lod.density = maxDensity;
+		}
+		else if (lod.density > 1 && ++lod.calmQueries >= COL_LOD_CALM_QUERIES) {
+			lod.density--;
+			lod.calmQueries = 0;
+		}
+	}
+
+	int GetMaxBumps() {
+		if (nBudgetQualityLevel >= 2) return 1;
+		if (nBudgetQualityLevel >= 1) return 2;
+		return 4;
+	}
+
+	int GetPhysicsSteps() {
+		int steps = std::max(nPhysicsSteps, 1);
+		if (nBudgetQualityLevel >= 2) return 1;
+		if (nBudgetQualityLevel >= 1) return (steps + 1) / 2;
+		return steps;
+	}
 
 	// get avg between min and max up, should end up 0 for HL1
 	float GetPlayerCenterUp() {
@@ -457,81 +684,85 @@ namespace FreemanAPI {
 
 	// for ground movement
 	pmtrace_t GetTopFloorForBBox(NyaVec3Double origin) {
-		std::vector<pmtrace_t> traces;
-
 		origin[UP] += GetPlayerCenterUp();
 
-		for (int x = -nColDensity; x <= nColDensity; x++) {
-			auto posX = (double)x / nColDensity;
-			for (int z = -nColDensity; z <= nColDensity; z++) {
-				auto posZ = (double)z / nColDensity;
-
-				auto bbox = GetCenterRelativeBBoxMax();
+		auto bbox = GetCenterRelativeBBoxMax();
 
-				// do a raycast from all sides downwards
+		// do a raycast from all sides downwards
+		// straight down from above each point of the footprint, a ray slanting out from the center would hit a slope short of the edge
+		rayBatch.Clear();
+		int density = GetColDensity(COL_QUERY_FLOOR);
+		for (int x = -density; x <= density; x++) {
+			auto posX = (double)x / density;
+			for (int z = -density; z <= density; z++) {
+				auto posZ = (double)z / density;
 
 				auto start = origin;
-				auto end = origin;
-				end[0] += posX * bbox.x;
-				end[FORWARD] += posZ * bbox[FORWARD];
+				start[0] += posX * bbox.x;
+				start[FORWARD] += posZ * bbox[FORWARD];
+				auto end = start;
 				end[UP] -= bbox[UP];
-
-				auto trace = PointRaytrace(start, end);
-				if (trace.ent != -1) {
-					trace.endpos[UP] += bbox[UP];
-					traces.push_back(trace);
-				}
+				rayBatch.Add(start, end);
 			}
 		}
+		rayBatch.Trace();
 
 		auto out = pmtrace_t();
 		out.Default();
 		out.endpos = {-999999,-999999,-999999};
-		for (auto& tr : traces) {
-			if (tr.ent != -1 && tr.endpos[UP] > out.endpos[UP]) out = tr;
-		}
+		int numHits = 0;
+		bool sloped = false;
+		double lowestHit = 999999;
+		for (auto& tr : rayBatch.traces) {
+			if (tr.ent == -1) continue;
+			tr.endpos[UP] += bbox[UP];
+			numHits++;
+			if (tr.plane.normal[UP] < 0.999) sloped = true; // walking onto a ramp, before the ground check has seen it, Trace has already put the normal in movement space
+			lowestHit = std::min(lowestHit, tr.endpos[UP]);
+			if (tr.endpos[UP] > out.endpos[UP]) out = tr;
+		}
+		// flat ground or nothing at all is easy, an edge, a step or a slope isn't
+		UpdateColLod(COL_QUERY_FLOOR, (numHits && numHits != (int)rayBatch.traces.size()) || (numHits && out.endpos[UP] - lowestHit > 1) || sloped);
 		out.endpos[UP] -= GetPlayerCenterUp();
 		return out;
 	}
 
 	// for unducking
 	pmtrace_t GetBottomCeilingForBBox(NyaVec3Double origin) {
-		std::vector<pmtrace_t> traces;
-
 		origin[UP] += GetPlayerCenterUp();
 
-		for (int x = -nColDensity; x <= nColDensity; x++) {
-			auto posX = (double)x / nColDensity;
-			for (int z = -nColDensity; z <= nColDensity; z++) {
-				auto posZ = (double)z / nColDensity;
-
-				auto bbox = GetCenterRelativeBBoxMax();
+		auto bbox = GetCenterRelativeBBoxMax();
 
-				// do a raycast from all sides upwards
+		// do a raycast from all sides upwards
+		rayBatch.Clear();
+		int density = GetColDensity(COL_QUERY_CEILING);
+		for (int x = -density; x <= density; x++) {
+			auto posX = (double)x / density;
+			for (int z = -density; z <= density; z++) {
+				auto posZ = (double)z / density;
 
-				// start from the very bottom
+				// start from the very bottom, straight up like the floor rays
 				auto start = origin;
+				start[0] += posX * bbox.x;
+				start[FORWARD] += posZ * bbox[FORWARD];
 				start[UP] -= bbox[UP];
 
-				auto end = origin;
-				end[0] += posX * bbox.x;
-				end[FORWARD] += posZ * bbox[FORWARD];
-				end[UP] += bbox[UP];
-
-				auto trace = PointRaytrace(start, end);
-				if (trace.ent != -1) {
-					trace.endpos[UP] -= bbox[UP];
-					traces.push_back(trace);
-				}
+				auto end = start;
+				end[UP] += bbox[UP] * 2;
+				rayBatch.Add(start, end);
 			}
 		}
+		rayBatch.Trace();
 
 		auto out = pmtrace_t();
 		out.Default();
 		out.endpos = {999999,999999,999999};
-		for (auto& tr : traces) {
-			if (tr.ent != -1 && tr.endpos[UP] < out.endpos[UP]) out = tr;
+		for (auto& tr : rayBatch.traces) {
+			if (tr.ent == -1) continue;
+			tr.endpos[UP] -= bbox[UP];
+			if (tr.endpos[UP] < out.endpos[UP]) out = tr;
 		}
+		UpdateColLod(COL_QUERY_CEILING, out.ent != -1);
 		out.endpos[UP] -= GetPlayerCenterUp();
 		return out;
 	}
@@ -544,46 +775,269 @@ namespace FreemanAPI {
 		origPos[UP] += GetPlayerCenterUp();
 		targetPos[UP] += GetPlayerCenterUp();
 
-		std::vector<pmtrace_t> traces;
+		auto bbox = GetCenterRelativeBBoxMax();
 
-		for (int x = -nColDensity; x <= nColDensity; x++) {
-			auto posX = (double)x / nColDensity;
-			for (int y = -nColDensity; y <= nColDensity; y++) {
-				auto posY = (double)y / nColDensity;
-				for (int z = -nColDensity; z <= nColDensity; z++) {
-					auto posZ = (double)z / nColDensity;
+		static FREEMANAPI_THREAD_LOCAL std::vector<NyaVec3Double> offsets;
+		offsets.clear();
 
-					auto bbox = GetCenterRelativeBBoxMax();
+		// cast from the origin outwards
+		rayBatch.Clear();
+		int density = GetColDensity(COL_QUERY_HULL);
+		for (int x = -density; x <= density; x++) {
+			auto posX = (double)x / density;
+			for (int y = -density; y <= density; y++) {
+				auto posY = (double)y / density;
+				for (int z = -density; z <= density; z++) {
+					auto posZ = (double)z / density;
 
-					// cast from the origin outwards
-					auto start = targetPos;
-					auto offset = targetPos;
+					NyaVec3Double offset;
 					offset.x = posX * bbox.x;
 					offset.y = posY * bbox.y;
 					offset.z = posZ * bbox.z;
+					offsets.push_back(offset);
+					rayBatch.Add(targetPos, targetPos + offset);
+				}
+			}
+		}
+		rayBatch.Trace();
+
+		auto out = pmtrace_t();
+		out.Default();
+		out.endpos = targetPos;
+		bool nearby = false;
+		for (int i = 0; i < (int)rayBatch.traces.size(); i++) {
+			auto& tr = rayBatch.traces[i];
+			if (tr.ent == -1) continue;
+			nearby = true;
+			tr.endpos -= offsets[i];
+			tr.fraction = (origPos - tr.endpos).length() / distanceTraveled;
+			if (tr.fraction < out.fraction) out = tr;
+		}
+		UpdateColLod(COL_QUERY_HULL, nearby);
+		out.endpos[UP] -= GetPlayerCenterUp();
+		return out;
+	}
+
+	const double DIST_EPSILON = 0.03125; // same gap the engine hull traces leave between the player and a plane
 
-					auto end = targetPos + offset;
+	const int SWEEP_MAX_RETRIES = 4;
 
-					auto trace = PointRaytrace(start, end);
-					if (trace.ent != -1) {
-						trace.endpos -= offset;
-						trace.fraction = (origPos - trace.endpos).length() / distanceTraveled;
-						traces.push_back(trace);
+	// casts rays across every leading face of the hull centered at pos, one per lattice row and column, just inside the box
+	// returns the first thing found sticking through a face, or nullptr
+	const pmtrace_t* GetLeadingFaceHit(const NyaVec3Double& pos, const NyaVec3Double& move, const NyaVec3Double& bbox, int density) {
+		auto inset = bbox;
+		for (int i = 0; i < 3; i++) {
+			inset[i] = std::max(bbox[i] - DIST_EPSILON * 0.5, 0.0);
+		}
+
+		rayBatch.Clear();
+		for (int axis = 0; axis < 3; axis++) {
+			if (move[axis] == 0) continue;
+
+			auto face = pos;
+			face[axis] += move[axis] > 0 ? inset[axis] : -inset[axis];
+			int u = (axis + 1) % 3;
+			int v = (axis + 2) % 3;
+			for (int i = -density; i <= density; i++) {
+				auto start = face;
+				start[u] += (double)i / density * inset[u];
+				start[v] -= inset[v];
+				auto end = start;
+				end[v] += inset[v] * 2;
+				rayBatch.Add(start, end);
+
+				start = face;
+				start[v] += (double)i / density * inset[v];
+				start[u] -= inset[u];
+				end = start;
+				end[u] += inset[u] * 2;
+				rayBatch.Add(start, end);
+			}
+		}
+		rayBatch.Trace();
+
+		for (auto& tr : rayBatch.traces) {
+			if (!tr.startsolid && tr.ent != -1) return &tr;
+		}
+		return nullptr;
+	}
+
+	// swept hull for the point raytrace fallback, a proper fraction and plane like PM_PlayerTrace
+	// rays go along the motion from every lattice point on the leading side of the box,
+	// the earliest hit any of them sees is where the hull gets stopped, pulled back so it stays off the plane
+	// anything thinner than the lattice spacing can slip between those rays, so the leading faces are then checked at the end
+	// and the hull pulled back further until they're clear
+	// a zero length move is just an overlap test
+	// with the adaptive density on the rays look fColLodMargin further ahead, that's how the sweep knows a wall is coming up
+	pmtrace_t SweepBBoxWithRays(NyaVec3Double origPos, NyaVec3Double targetPos) {
+		auto move = targetPos - origPos;
+		auto distance = move.length();
+		if (distance <= 0) return GetClosestBBoxIntersection(origPos, targetPos);
+
+		auto from = origPos;
+		origPos[UP] += GetPlayerCenterUp();
+
+		auto bbox = GetCenterRelativeBBoxMax();
+		auto rayLength = distance + (bAdaptiveColDensity ? fColLodMargin : 0);
+		auto ray = move * (rayLength / distance);
+
+		rayBatch.Clear();
+		int density = GetColDensity(COL_QUERY_HULL);
+		for (int x = -density; x <= density; x++) {
+			for (int y = -density; y <= density; y++) {
+				for (int z = -density; z <= density; z++) {
+					int index[3] = { x, y, z };
+					bool leading = false;
+					for (int i = 0; i < 3; i++) {
+						if (std::abs(index[i]) == density && index[i] * move[i] > 0) leading = true;
 					}
+					if (!leading) continue;
+
+					auto start = origPos;
+					start.x += (double)x / density * bbox.x;
+					start.y += (double)y / density * bbox.y;
+					start.z += (double)z / density * bbox.z;
+					rayBatch.Add(start, start + ray);
 				}
 			}
 		}
+		rayBatch.Trace();
 
 		auto out = pmtrace_t();
 		out.Default();
-		out.endpos = targetPos;
-		for (auto& tr : traces) {
-			if (tr.ent != -1 && tr.fraction < out.fraction) out = tr;
+		bool nearby = false;
+		for (auto& tr : rayBatch.traces) {
+			// a sample that's already inside something can't tell us where the hull hits, let it move out
+			if (tr.startsolid) {
+				if (!out.startsolid) FlagStuckCheck(from);
+				out.startsolid = true;
+				nearby = true;
+				continue;
+			}
+			if (tr.ent == -1) continue;
+			nearby = true;
+
+			auto fraction = tr.fraction * rayLength / distance;
+			if (fraction >= out.fraction) continue;
+			out.fraction = fraction;
+			out.plane = tr.plane;
+			out.ent = tr.ent;
+			out.surfaceId = tr.surfaceId;
+			out.inwater = tr.inwater;
+		}
+
+		if (out.fraction < 1) {
+			// back off far enough along the motion to leave DIST_EPSILON to the plane, glancing hits are capped
+			auto approach = -DotProduct(out.plane.normal, move) / distance;
+			auto backoff = DIST_EPSILON / std::max(approach, 0.25);
+			out.fraction = std::max(out.fraction * distance - backoff, 0.0) / distance;
+		}
+
+		// a hull that started out stuck has to be let out, the faces would only find what it's stuck in
+		if (!out.startsolid) {
+			for (int i = 0; out.fraction > 0; i++) {
+				auto hit = GetLeadingFaceHit(origPos + move * out.fraction, move, bbox, density);
+				if (!hit) break;
+
+				nearby = true;
+				out.fraction = i < SWEEP_MAX_RETRIES ? out.fraction * 0.5 : 0;
+				out.plane.normal = move * (-1.0 / distance);
+				out.ent = hit->ent;
+				out.surfaceId = hit->surfaceId;
+				out.inwater = hit->inwater;
+			}
 		}
+		UpdateColLod(COL_QUERY_HULL, nearby);
+		out.endpos = origPos + move * out.fraction;
 		out.endpos[UP] -= GetPlayerCenterUp();
 		return out;
 	}
 
+	// overlap test for the point raytrace fallback, only says whether the hull fits and not where it's blocked
+	// rays from the center out to the corners and face centers, pulled in by DIST_EPSILON so resting against a plane doesn't count
+	bool TestBBoxWithRays(NyaVec3Double origin) {
+		origin[UP] += GetPlayerCenterUp();
+
+		auto bbox = GetCenterRelativeBBoxMax();
+		for (int i = 0; i < 3; i++) {
+			bbox[i] = std::max(bbox[i] - DIST_EPSILON, 0.0);
+		}
+
+		rayBatch.Clear();
+		for (int x = -1; x <= 1; x++) {
+			for (int y = -1; y <= 1; y++) {
+				for (int z = -1; z <= 1; z++) {
+					int numOnSide = std::abs(x) + std::abs(y) + std::abs(z);
+					if (numOnSide != 1 && numOnSide != 3) continue;
+
+					auto end = origin;
+					end.x += x * bbox.x;
+					end.y += y * bbox.y;
+					end.z += z * bbox.z;
+					rayBatch.Add(origin, end);
+				}
+			}
+		}
+		rayBatch.Trace();
+
+		for (auto& tr : rayBatch.traces) {
+			if (tr.startsolid || tr.ent != -1) return true;
+		}
+		return false;
+	}
+
+	// registered water volumes first, the host callback only gets asked about points outside all of them
+	int PM_PointContents(const NyaVec3Double& point) {
+		int id = FindWaterVolume(point);
+		if (id >= 0) {
+			FREEMANAPI_STAT_INC(numWaterVolumeHits);
+			return aWaterVolumes[id].contents;
+		}
+		return GetPointContentsGame(&point);
+	}
+
+	// the last surface query, PM_CheckWater asks about the same spot several times per substep
+	struct tWaterSurfaceCache {
+		NyaVec3Double point;
+		int contents;
+		double surface;
+		bool valid = false;
+	};
+	FREEMANAPI_THREAD_LOCAL tWaterSurfaceCache waterSurfaceCache;
+
+	// contents at the point and the water surface height above it in movement units
+	// false if neither a registered volume nor the host can answer that, then it's down to point contents
+	bool GetWaterSurface(const NyaVec3Double& point, int* contents, double* surface) {
+		if (GetWaterVolumeSurface(point, contents, surface)) {
+			FREEMANAPI_STAT_INC(numWaterVolumeHits);
+			return true;
+		}
+		if (!EXT_GetWaterSurfaceHeight) return false;
+
+		auto& cache = waterSurfaceCache;
+		if (cache.valid && cache.point.x == point.x && cache.point.y == point.y && cache.point.z == point.z) {
+			*contents = cache.contents;
+			*surface = cache.surface;
+			return true;
+		}
+
+		auto gamePoint = point;
+		if (bConvertUnits) {
+			for (int i = 0; i < 3; i++) {
+				gamePoint[i] = UnitsToMeters(gamePoint[i]);
+			}
+			gamePoint *= vXYZUnitsMult;
+		}
+		*surface = GetWaterSurfaceHeightGame(&gamePoint, contents);
+		if (bConvertUnits) *surface = MetersToUnits(*surface) * vXYZUnitsMult[UP];
+
+		cache.point = point;
+		cache.contents = *contents;
+		cache.surface = *surface;
+		cache.valid = true;
+		return true;
+	}
+
 	bool PM_CheckWater() {
 		NyaVec3Double point;
 		int	cont;
@@ -600,8 +1054,23 @@ namespace FreemanAPI {
 		pmove->waterlevel = 0;
 		pmove->watertype = CONTENTS_EMPTY;
 
+		// the surface height answers the waist and eye probes too
+		double surface;
+		if (GetWaterSurface(point, &cont, &surface)) {
+			if (cont > CONTENTS_WATER) return false;
+			pmove->watertype = cont;
+			pmove->waterlevel = 1;
+			if (pmove->origin[UP] + (pmove->player_mins[GetPlayerHullID()][UP] + pmove->player_maxs[GetPlayerHullID()][UP]) * 0.5 <= surface) {
+				pmove->waterlevel = 2;
+				if (pmove->origin[UP] + pmove->view_ofs[UP] <= surface) {
+					pmove->waterlevel = 3;
+				}
+			}
+			return pmove->waterlevel > 1;
+		}
+
 		// Grab point contents.
-		cont = GetPointContentsGame(&point);
+		cont = PM_PointContents(point);
 		// Are we under water? (not solid and not empty?)
 		if (cont <= CONTENTS_WATER) {
 			// Set water type
@@ -615,7 +1084,7 @@ namespace FreemanAPI {
 
 			// Now check a point that is at the player hull midpoint.
 			point[UP] = pmove->origin[UP] + heightover2;
-			cont = GetPointContentsGame(&point);
+			cont = PM_PointContents(point);
 			// If that point is also under water...
 			if (cont <= CONTENTS_WATER) {
 				// Set a higher water level.
@@ -624,7 +1093,7 @@ namespace FreemanAPI {
 				// Now check the eye position.  (view_ofs is relative to the origin)
 				point[UP] = pmove->origin[UP] + pmove->view_ofs[UP];
 
-				cont = GetPointContentsGame(&point);
+				cont = PM_PointContents(point);
 				if (cont <= CONTENTS_WATER) {
 					pmove->waterlevel = 3;  // In over our eyes
 				}
@@ -646,8 +1115,31 @@ namespace FreemanAPI {
 		return pmove->waterlevel > 1;
 	}
 
-	float fLastPlaneNormal;
+	// Add it if it's not already in the list, the first hit on each entity and plane keeps its impact velocity
+	void PM_AddToTouched(const pmtrace_t& trace, const NyaVec3Double& impactvelocity) {
+		auto& buffer = GetContext()->touches;
+		for (int i = 0; i < buffer.count; i++) {
+			auto& touch = buffer.touches[i];
+			if (touch.ent == trace.ent && DotProduct(touch.normal, trace.plane.normal) > 0.999) return;
+		}
+
+		if (buffer.count >= MAX_TOUCHES) {
+			FREEMANAPI_STAT_INC(numTouchesDropped);
+			return;
+		}
+		FREEMANAPI_STAT_INC(numTouches);
+
+		auto& touch = buffer.touches[buffer.count++];
+		touch.ent = trace.ent;
+		touch.surfaceId = trace.surfaceId;
+		touch.normal = trace.plane.normal;
+		touch.velocity = impactvelocity;
+	}
+
 	void PM_CatagorizePosition() {
+		FREEMANAPI_STAT_TIME(microsCatagorizePosition);
+		FREEMANAPI_TIMELINE_SCOPE("PM_CatagorizePosition");
+
 		NyaVec3Double point;
 		pmtrace_t tr;
 
@@ -679,7 +1171,7 @@ namespace FreemanAPI {
 				tr = PM_PlayerTraceDown(pmove->origin, point);
 			}
 
-			fLastPlaneNormal = tr.plane.normal[UP];
+			pmove->flLastPlaneNormal = tr.plane.normal[UP];
 			// If we hit a steep plane, we are not on ground
 			if (tr.plane.normal[UP] < 0.7) {
 				pmove->onground = -1;    // too steep
@@ -705,21 +1197,19 @@ namespace FreemanAPI {
 				}
 			}
 
-			// todo
 			// Standing on an entity other than the world
-			//if (tr.ent > 0) { // So signal that we are touching something.
-			//	PM_AddToTouched(tr, pmove->velocity);
-			//}
+			if (tr.ent > 0) { // So signal that we are touching something.
+				PM_AddToTouched(tr, pmove->velocity);
+			}
 		}
 	}
 
 	void PM_PlayStepSound(int step, float fvol) {
-		static int iSkipStep = 0;
 		NyaVec3Double hvel;
 
 		pmove->iStepLeft = !pmove->iStepLeft;
 
-		int irand = (rand() % 2) + (pmove->iStepLeft * 2);
+		int irand = (PM_RandomInt(2)) + (pmove->iStepLeft * 2);
 
 		VectorCopy(pmove->velocity, hvel);
 		hvel[UP] = 0.0;
@@ -941,7 +1431,7 @@ namespace FreemanAPI {
 					}
 					break;
 				case CHAR_TEX_TILE:
-					if (!(rand() % 5)) {
+					if (!(PM_RandomInt(5))) {
 						irand = 4;
 					}
 
@@ -966,13 +1456,13 @@ namespace FreemanAPI {
 					}
 					break;
 				case CHAR_TEX_WADE:
-					if (iSkipStep == 0) {
-						iSkipStep++;
+					if (pmove->iSkipStep == 0) {
+						pmove->iSkipStep++;
 						break;
 					}
 
-					if (iSkipStep++ == 3) {
-						iSkipStep = 0;
+					if (pmove->iSkipStep++ == 3) {
+						pmove->iSkipStep = 0;
 					}
 
 					switch (irand) {
@@ -998,7 +1488,11 @@ namespace FreemanAPI {
 		}
 	}
 
+	FREEMANAPI_THREAD_LOCAL bool bOnLadder = false; // g_onladder, set by PM_PlayerMove before the step sounds
+
 	void PM_UpdateStepSound() {
+		FREEMANAPI_TIMELINE_SCOPE("PM_UpdateStepSound");
+
 		int	fWalking;
 		float fvol;
 		NyaVec3Double knee;
@@ -1021,7 +1515,7 @@ namespace FreemanAPI {
 		speed = pmove->velocity.length();
 
 		// determine if we are on a ladder
-		fLadder = pmove->movetype == MOVETYPE_FLY; // IsOnLadder();
+		fLadder = bOnLadder;
 
 		// UNDONE: need defined numbers for run, walk, crouch, crouch run velocities!!!!
 		if ((pmove->flags & FL_DUCKING) || fLadder) {
@@ -1055,11 +1549,31 @@ namespace FreemanAPI {
 			knee[UP] = pmove->origin[UP] - 0.3 * height;
 			feet[UP] = pmove->origin[UP] - 0.5 * height;
 
-			if (GetPointContentsGame(&knee) == CONTENTS_WATER) {
+			// one surface query covers both the knee and the feet
+			bool kneeInWater = false, feetInWater = false;
+			int cont;
+			double surface;
+			if (fLadder) {
+				// ladder steps win over water, no need to ask
+			}
+			else if (GetWaterSurface(feet, &cont, &surface)) {
+				feetInWater = cont == CONTENTS_WATER;
+				kneeInWater = feetInWater && knee[UP] <= surface;
+			}
+			else {
+				kneeInWater = PM_PointContents(knee) == CONTENTS_WATER;
+				feetInWater = kneeInWater || PM_PointContents(feet) == CONTENTS_WATER;
+			}
+
+			if (fLadder) {
+				step = CHAR_TEX_LADDER;
+				fvol = 0.35;
+				pmove->flTimeStepSound = 350;
+			} else if (kneeInWater) {
 				step = CHAR_TEX_WADE;
 				fvol = 0.65;
 				pmove->flTimeStepSound = 600;
-			} else if (GetPointContentsGame(&feet) == CONTENTS_WATER) {
+			} else if (feetInWater) {
 				step = CHAR_TEX_SLOSH;
 				fvol = fWalking ? 0.2 : 0.5;
 				pmove->flTimeStepSound = fWalking ? 400 : 300;
@@ -1150,6 +1664,7 @@ namespace FreemanAPI {
 			if (trace.startsolid) {
 				// See if we are stuck?  If so, stay ducked with the duck hull until we have a clear spot
 				lastConsoleMsg = "unstick got stuck";
+				FREEMANAPI_STAT_INC(numUnduckStuck);
 				pmove->usehull = 1;
 				return;
 			}
@@ -1175,6 +1690,9 @@ namespace FreemanAPI {
 	}
 
 	void PM_Duck() {
+		FREEMANAPI_STAT_TIME(microsDuckHL1);
+		FREEMANAPI_TIMELINE_SCOPE("PM_Duck");
+
 		float time;
 		float duckFraction;
 
@@ -1312,10 +1830,12 @@ namespace FreemanAPI {
 				// Bound it.
 				if (pmove->velocity[i] > movevars->maxvelocity) {
 					lastConsoleMsg = "PM Got a velocity too high on " + std::to_string(i);
+					FREEMANAPI_STAT_INC(numVelocityClamps);
 					pmove->velocity[i] = movevars->maxvelocity;
 				}
 				else if (pmove->velocity[i] < -movevars->maxvelocity) {
 					lastConsoleMsg = "PM Got a velocity too low on " + std::to_string(i);
+					FREEMANAPI_STAT_INC(numVelocityClamps);
 					pmove->velocity[i] = -movevars->maxvelocity;
 				}
 			}
@@ -1348,6 +1868,8 @@ namespace FreemanAPI {
 	}
 
 	void PM_Friction() {
+		FREEMANAPI_TIMELINE_SCOPE("PM_Friction");
+
 		NyaVec3Double vel;
 		float speed, newspeed, control;
 		float friction;
@@ -1501,7 +2023,10 @@ namespace FreemanAPI {
 		}
 	}
 
-	int PM_FlyMove() {
+	int PM_FlyMove(const tKnownTrace* firstTrace = nullptr) {
+		FREEMANAPI_STAT_TIME(microsFlyMove);
+		FREEMANAPI_TIMELINE_SCOPE("PM_FlyMove");
+
 		int	bumpcount, numbumps;
 		NyaVec3Double dir;
 		float d;
@@ -1514,7 +2039,7 @@ namespace FreemanAPI {
 		float time_left, allFraction;
 		int	blocked;
 
-		numbumps  = IsUsingPlayerTraceFallback() ? 1 : 4;	// Bump up to four times
+		numbumps  = GetMaxBumps();	// Bump up to four times
 
 		blocked   = 0;           // Assume not blocked
 		numplanes = 0;           //  and not sliding along any planes
@@ -1529,13 +2054,18 @@ namespace FreemanAPI {
 				break;
 			}
 
+			FREEMANAPI_STAT_INC(numBumpIterations);
+
 			// Assume we can move all the way from the current origin to the
 			//  end point.
 			end = pmove->origin + pmove->velocity * time_left;
 
 			// See if we can make it from origin to end point.
-			if (IsUsingPlayerTraceFallback()) {
-				trace = GetClosestBBoxIntersection(pmove->origin, end);
+			if (bumpcount == 0 && firstTrace && firstTrace->Matches(pmove->origin, end)) {
+				trace = firstTrace->trace;
+			}
+			else if (IsUsingPlayerTraceFallback()) {
+				trace = SweepBBoxWithRays(pmove->origin, end);
 			}
 			else {
 				trace = PM_PlayerTrace(pmove->origin, end);
@@ -1548,6 +2078,7 @@ namespace FreemanAPI {
 			if (trace.allsolid) { // entity is trapped in another solid
 				VectorCopy(vec3_origin, pmove->velocity);
 				lastConsoleMsg = "Trapped 4";
+				FREEMANAPI_STAT_INC(numTrapped);
 				return 4;
 			}
 
@@ -1564,11 +2095,10 @@ namespace FreemanAPI {
 			//  and can return.
 			if (trace.fraction == 1.0f) break; // moved the entire distance
 
-			// todo
 			// Save entity that blocked us (since fraction was < 1.0)
 			//  for contact
 			// Add it if it's not already in the list!!!
-			//PM_AddToTouched(trace, pmove->velocity);
+			PM_AddToTouched(trace, pmove->velocity);
 
 			// If the plane we hit has a high z component in the normal, then
 			//  it's probably a floor
@@ -1580,6 +2110,7 @@ namespace FreemanAPI {
 			if (!trace.plane.normal[UP]) {
 				blocked |= 2;		// step / wall
 				lastConsoleMsg = "Blocked by " + std::to_string(trace.ent);
+				FREEMANAPI_STAT_INC(numBlockedByWall);
 			}
 
 			// Reduce amount of pmove->frametime left by total time left * fraction
@@ -1591,6 +2122,7 @@ namespace FreemanAPI {
 				//  Stop our movement if so.
 				VectorCopy(vec3_origin, pmove->velocity);
 				lastConsoleMsg = "Too many planes 4";
+				FREEMANAPI_STAT_INC(numClipPlaneOverflows);
 				break;
 			}
 
@@ -1641,6 +2173,7 @@ namespace FreemanAPI {
 				else { // go along the crease
 					if (numplanes != 2) {
 						lastConsoleMsg = "clip velocity, numplanes == " + std::to_string(numplanes);
+						FREEMANAPI_STAT_INC(numCreaseStops);
 						VectorCopy(vec3_origin, pmove->velocity);
 						break;
 					}
@@ -1655,6 +2188,7 @@ namespace FreemanAPI {
 				//
 				if (DotProduct(pmove->velocity, primal_velocity) <= 0) {
 					lastConsoleMsg = "Back";
+					FREEMANAPI_STAT_INC(numBackStops);
 					VectorCopy(vec3_origin, pmove->velocity);
 					break;
 				}
@@ -1664,6 +2198,7 @@ namespace FreemanAPI {
 		if (allFraction == 0) {
 			VectorCopy(vec3_origin, pmove->velocity);
 			lastConsoleMsg = "Don't stick";
+			FREEMANAPI_STAT_INC(numDontStick);
 		}
 
 		if (bHL2Mode) {
@@ -1690,6 +2225,8 @@ namespace FreemanAPI {
 	}
 
 	void PM_WaterMove() {
+		FREEMANAPI_TIMELINE_SCOPE("PM_WaterMove");
+
 		NyaVec3Double wishvel;
 		float wishspeed;
 		NyaVec3Double wishdir;
@@ -1780,6 +2317,8 @@ namespace FreemanAPI {
 	}
 
 	void PM_AirMove() {
+		FREEMANAPI_TIMELINE_SCOPE("PM_AirMove");
+
 		NyaVec3Double wishvel;
 		float fmove, smove;
 		NyaVec3Double wishdir;
@@ -1850,6 +2389,9 @@ namespace FreemanAPI {
 	}
 
 	void PM_WalkMove() {
+		FREEMANAPI_STAT_TIME(microsWalkMove);
+		FREEMANAPI_TIMELINE_SCOPE("PM_WalkMove");
+
 		int clip;
 		int oldonground;
 
@@ -1905,6 +2447,7 @@ namespace FreemanAPI {
 		if (spd < 1.0f) {
 			VectorClear(pmove->velocity);
 			lastConsoleMsg = "clearing small speed";
+			FREEMANAPI_STAT_INC(numSmallSpeedClears);
 			return;
 		}
 
@@ -1918,8 +2461,25 @@ namespace FreemanAPI {
 		// first try moving directly to the next spot
 		VectorCopy(dest, start);
 
+		// the stair path starts with a trace straight up from here, nothing in between changes that
+		// with a batch callback it goes to the host together with the direct move, wasted if that makes it but still one host call
+		// a replay serves the traces back one at a time in the order they're used, so not while recording
+		bool batchStepUp = EXT_PM_PlayerTraceBatch && EXT_PM_PlayerTrace && !IsRecordingReplay() && !replayReader.IsActive()
+				&& (oldonground != -1 || pmove->waterlevel != 0) && !pmove->waterjumptime;
+		pmtrace_t stepUpTrace;
+
 		if (IsUsingPlayerTraceFallback()) {
-			trace = GetClosestBBoxIntersection(pmove->origin, dest);
+			batchStepUp = false;
+			trace = SweepBBoxWithRays(pmove->origin, dest);
+		}
+		else if (batchStepUp) {
+			NyaVec3Double starts[2] = { pmove->origin, pmove->origin };
+			NyaVec3Double ends[2] = { dest, pmove->origin };
+			ends[1][UP] += movevars->stepsize;
+			pmtrace_t traces[2];
+			PM_PlayerTraceBatch(starts, ends, 2, traces);
+			trace = traces[0];
+			stepUpTrace = traces[1];
 		}
 		else {
 			trace = PM_PlayerTrace(pmove->origin, dest);
@@ -1935,13 +2495,16 @@ namespace FreemanAPI {
 		if (oldonground == -1 && pmove->waterlevel == 0) return; // Don't walk up stairs if not on ground.
 		if (pmove->waterjumptime) return; // If we are jumping out of water, don't do anything more.
 
+		// the slide move starts off with this exact trace, no need to do it twice
+		tKnownTrace directTrace = { pmove->origin, dest, trace };
+
 		// Try sliding forward both on ground and up 16 pixels
 		//  take the move that goes farthest
 		VectorCopy(pmove->origin, original);       // Save out original pos &
 		VectorCopy(pmove->velocity, originalvel);  //  velocity.
 
 		// Slide move
-		clip = PM_FlyMove();
+		clip = PM_FlyMove(&directTrace);
 
 		// Copy the results out
 		VectorCopy(pmove->origin, down);
@@ -1952,12 +2515,21 @@ namespace FreemanAPI {
 
 		VectorCopy(originalvel, pmove->velocity);
 
+		// the stair path can't get over anything taller than a step, skip it if the host knows that's what's in the way
+		if (GetStepHeight(original, dest) > movevars->stepsize) {
+			FREEMANAPI_STAT_INC(numStepUpSkips);
+			goto usedown;
+		}
+
 		// Start out up one stair height
 		VectorCopy(pmove->origin, dest);
 		dest[UP] += movevars->stepsize;
 
 		if (IsUsingPlayerTraceFallback()) {
-			trace = GetClosestBBoxIntersection(pmove->origin, dest);
+			trace = SweepBBoxWithRays(pmove->origin, dest);
+		}
+		else if (batchStepUp) {
+			trace = stepUpTrace;
 		}
 		else {
 			trace = PM_PlayerTrace(pmove->origin, dest);
@@ -1979,7 +2551,7 @@ namespace FreemanAPI {
 		dest[UP] -= movevars->stepsize;
 
 		if (IsUsingPlayerTraceFallback()) {
-			trace = GetClosestBBoxIntersection(pmove->origin, dest);
+			trace = SweepBBoxWithRays(pmove->origin, dest);
 		}
 		else {
 			trace = PM_PlayerTrace(pmove->origin, dest);
@@ -2069,7 +2641,7 @@ namespace FreemanAPI {
 				// Don't play sound again for 1 second
 				pmove->flSwimTime = 1000;
 
-				switch (rand() % 4) {
+				switch (PM_RandomInt(4)) {
 					case 0:
 						PlayGameSound("player/pl_wade1.wav", 1);
 						break;
@@ -2446,7 +3018,7 @@ namespace FreemanAPI {
 		auto vecEnd = pmove->origin;
 		vecEnd[UP] -= 36.0f;						// This will have to change if bounding hull change!
 		if (IsUsingPlayerTraceFallback()) {
-			trace = GetClosestBBoxIntersection(pmove->origin, vecEnd);
+			trace = SweepBBoxWithRays(pmove->origin, vecEnd);
 		}
 		else {
 			trace = PM_PlayerTraceDown(pmove->origin, vecEnd);
@@ -2510,6 +3082,9 @@ namespace FreemanAPI {
 	}
 
 	void Duck() {
+		FREEMANAPI_STAT_TIME(microsDuckHL2);
+		FREEMANAPI_TIMELINE_SCOPE("Duck");
+
 		auto mv = pmove;
 		int buttonsChanged	= (mv->oldbuttons ^ mv->cmd.buttons);	// These buttons have changed this frame
 		int buttonsPressed	=  buttonsChanged & mv->cmd.buttons;	// The changed ones still down are "pressed"
@@ -2819,7 +3394,7 @@ namespace FreemanAPI {
 					pmove->flFallVelocity -= PLAYER_MAX_SAFE_FALL_SPEED_HL2;
 					OnTakeFallDamage(pmove->flFallVelocity * DAMAGE_FOR_FALL_SPEED_HL2);
 					
-					switch (rand() % 2) {
+					switch (PM_RandomInt(2)) {
 						case 0:
 							PlayGameSound("player/pl_fallpain1.wav", 1);
 							break;
@@ -2941,7 +3516,7 @@ namespace FreemanAPI {
 		VectorAdd(pmove->origin, push, end);
 
 		if (IsUsingPlayerTraceFallback()) {
-			trace = GetClosestBBoxIntersection(pmove->origin, end);
+			trace = SweepBBoxWithRays(pmove->origin, end);
 		}
 		else {
 			trace = PM_PlayerTrace(pmove->origin, end);
@@ -2949,16 +3524,17 @@ namespace FreemanAPI {
 
 		VectorCopy(trace.endpos, pmove->origin);
 
-		// todo
 		// So we can run impact function afterwards.
-		//if (trace.fraction < 1.0 && !trace.allsolid) {
-		//	PM_AddToTouched(trace, pmove->velocity);
-		//}
+		if (trace.fraction < 1.0 && !trace.allsolid) {
+			PM_AddToTouched(trace, pmove->velocity);
+		}
 
 		return trace;
 	}
 
 	void PM_Physics_Toss() {
+		FREEMANAPI_TIMELINE_SCOPE("PM_Physics_Toss");
+
 		pmtrace_t trace;
 		NyaVec3Double move;
 		float backoff;
@@ -3050,15 +3626,325 @@ namespace FreemanAPI {
 		PM_CheckWater();
 	}
 
+	const float MAX_CLIMB_SPEED = 200;
+
+	// the registered ladder the hull is in, -1 if none
+	// hl2 only grabs a ladder the player is moving into, then stays on it until the hull leaves it
+	int PM_Ladder() {
+		auto hull = GetPlayerHullID();
+		int id = FindLadder(pmove->origin, pmove->player_mins[hull], pmove->player_maxs[hull]);
+		if (id < 0 || !bHL2Mode || id == pmove->iLadder) return id;
+
+		auto wishdir = pmove->forward * pmove->cmd.forwardmove + pmove->right * pmove->cmd.sidemove;
+		if (DotProduct(wishdir, aLadders[id].axes[0]) >= 0) return -1;
+		return id;
+	}
+
+	void PM_LadderMove(int id) {
+		if (pmove->movetype == MOVETYPE_NOCLIP) return;
+
+		auto& normal = aLadders[id].axes[0];
+
+		pmove->movetype = MOVETYPE_FLY;
+		pmove->iLadder = id;
+
+		// On ladder, convert movement to be relative to the ladder
+		// the original checks for solid right under the feet, there's no solid contents here so the ground check stands in
+		bool onFloor = pmove->onground != -1;
+
+		pmove->gravity = 0;
+
+		float flSpeed = MAX_CLIMB_SPEED;
+		if (!bHL2Mode) {
+			// they shouldn't be able to move faster than their maxspeed
+			flSpeed = std::min(flSpeed, pmove->maxspeed);
+
+			if (pmove->flags & FL_DUCKING) {
+				flSpeed *= PLAYER_DUCKING_MULTIPLIER;
+			}
+		}
+
+		// the original goes off the movement buttons, any push on the stick climbs at full speed the same way
+		float forward = 0, right = 0;
+		if (pmove->cmd.forwardmove < 0) forward -= flSpeed;
+		if (pmove->cmd.forwardmove > 0) forward += flSpeed;
+		if (pmove->cmd.sidemove < 0) right -= flSpeed;
+		if (pmove->cmd.sidemove > 0) right += flSpeed;
+
+		if (pmove->cmd.buttons & IN_JUMP) {
+			pmove->movetype = MOVETYPE_WALK;
+			pmove->iLadder = -1;
+			VectorScale(normal, 270, pmove->velocity);
+		}
+		else if (forward != 0 || right != 0) {
+			// Calculate player's intended velocity
+			NyaVec3Double velocity;
+			VectorScale(pmove->forward, forward, velocity);
+			VectorMA(velocity, right, pmove->right, velocity);
+
+			// Perpendicular in the ladder plane
+			NyaVec3Double up = {0,0,0};
+			up[UP] = 1;
+			auto perp = CrossProduct(up, normal);
+			VectorNormalize(perp);
+
+			// decompose velocity into ladder plane
+			float into = DotProduct(velocity, normal);
+
+			// This is the velocity into the face of the ladder
+			NyaVec3Double cross;
+			VectorScale(normal, into, cross);
+
+			// This is the player's additional velocity
+			NyaVec3Double lateral;
+			VectorSubtract(velocity, cross, lateral);
+
+			// This turns the velocity into the face of the ladder into velocity that
+			// is roughly vertically perpendicular to the face of the ladder.
+			// NOTE: It IS possible to face up and move down or face down and move up
+			// because the velocity is a sum of the directional velocity and the converted
+			// velocity through the face of the ladder -- by design.
+			VectorMA(lateral, -into, CrossProduct(normal, perp), pmove->velocity);
+			if (onFloor && into > 0) { // On ground moving away from the ladder
+				VectorMA(pmove->velocity, MAX_CLIMB_SPEED, normal, pmove->velocity);
+			}
+		}
+		else {
+			VectorClear(pmove->velocity);
+		}
+	}
+
+	// what the host said about an entity this frame, in movement units
+	// angular is pitch, yaw and roll rates in degrees per second, in the same order as the view angles
+	struct tEntityVelocity {
+		int ent;
+		bool moving;
+		NyaVec3Double origin;
+		NyaVec3Double velocity;
+		NyaVec3Double angular;
+	};
+	FREEMANAPI_THREAD_LOCAL std::vector<tEntityVelocity> aEntityVelocities; // cleared every frame, each entity is only asked about once however many substeps stand on it
+
+	const tEntityVelocity& GetCachedEntityVelocity(int ent) {
+		for (auto& cached : aEntityVelocities) {
+			if (cached.ent == ent) return cached;
+		}
+
+		tEntityVelocity cached;
+		cached.ent = ent;
+		cached.moving = GetEntityVelocityGame(ent, &cached.origin, &cached.velocity, &cached.angular);
+		if (bConvertUnits) {
+			for (int i = 0; i < 3; i++) {
+				cached.origin[i] = MetersToUnits(cached.origin[i]);
+				cached.velocity[i] = MetersToUnits(cached.velocity[i]);
+			}
+			cached.origin *= vXYZUnitsMult;
+			cached.velocity *= vXYZUnitsMult;
+		}
+		aEntityVelocities.push_back(cached);
+		return aEntityVelocities.back();
+	}
+
+	// velocity of the ground entity right under the player, its spin included, false if it isn't moving
+	// only spin around the up axis carries the player, pitch and roll would need the player tilted with it
+	// frametime is how long the player rides it for, the turn is spread over that
+	bool GetGroundEntityVelocity(int ent, double frametime, NyaVec3Double& velocity, double& yawRate) {
+		auto& cached = GetCachedEntityVelocity(ent);
+		if (!cached.moving) return false;
+
+		velocity = cached.velocity;
+		yawRate = cached.angular[YAW];
+		if (yawRate != 0 && frametime > 0) {
+			// turning yaw moves the forward vector towards the one 90 degrees further round, whichever way the axes are set up
+			NyaVec3Double angles = {0,0,0}, forward, side;
+			AngleVectors(angles, forward);
+			angles[YAW] = 90;
+			AngleVectors(angles, side);
+
+			// the chord the player's spot moves along this substep rather than the tangent, so they don't drift outwards
+			auto offset = pmove->origin - cached.origin;
+			double a = DotProduct(offset, forward);
+			double b = DotProduct(offset, side);
+			double turn = yawRate * frametime * (std::numbers::pi / 180.0);
+			auto moved = forward * (a * std::cos(turn) - b * std::sin(turn)) + side * (a * std::sin(turn) + b * std::cos(turn));
+			velocity += (moved - forward * a - side * b) * (1.0 / frametime);
+		}
+		return true;
+	}
+
+	// basevelocity is the ground entity's horizontal velocity on top of whatever the water currents add,
+	// the vertical part is left out as the gravity code treats it as an impulse, lifts are ridden in PM_RideBaseEntity instead
+	// getting on or off an entity trades its velocity in and out of the player's own, so jumping off a train keeps its speed
+	void PM_UpdateBaseVelocity() {
+		NyaVec3Double velocity = {0,0,0};
+		double yawRate = 0;
+		int ent = pmove->onground;
+		if (ent != -1 && !GetGroundEntityVelocity(ent, pmove->frametime, velocity, yawRate)) ent = -1;
+
+		auto oldHorizontal = pmove->vecBaseEntVelocity;
+		oldHorizontal[UP] = 0;
+		auto horizontal = velocity;
+		horizontal[UP] = 0;
+
+		if (ent != pmove->iBaseEnt) {
+			VectorAdd(pmove->velocity, pmove->vecBaseEntVelocity, pmove->velocity);
+			VectorSubtract(pmove->velocity, horizontal, pmove->velocity);
+		}
+		pmove->basevelocity += horizontal - oldHorizontal;
+		pmove->iBaseEnt = ent;
+		pmove->vecBaseEntVelocity = velocity;
+
+		// turn the view with the platform, the input setup adds the whole turn to the host's view angle from then on
+		if (yawRate != 0) {
+			double turn = yawRate * pmove->frametime;
+			pmove->flCarriedYaw = std::fmod(pmove->flCarriedYaw + turn, 360.0);
+			pmove->cmd.viewangles[YAW] += turn;
+			pmove->angles[YAW] += turn;
+		}
+	}
+
+	// the host moves its lifts itself, so the player gets moved up or down by as much at the start of the frame
+	void PM_RideBaseEntity(double delta) {
+		if (pmove->iBaseEnt == -1 || pmove->onground != pmove->iBaseEnt) return;
+
+		NyaVec3Double velocity;
+		double yawRate;
+		if (!GetGroundEntityVelocity(pmove->iBaseEnt, delta, velocity, yawRate) || velocity[UP] == 0) return;
+
+		NyaVec3Double push = {0,0,0};
+		push[UP] = velocity[UP] * delta;
+		auto trace = PM_PushEntity(push);
+		if (!trace.startsolid) return;
+
+		// the lift has already come up into the player, see if the spot on top of it is clear
+		auto end = pmove->origin + push;
+		if (IsUsingPlayerTraceFallback()) {
+			trace = GetBottomCeilingForBBox(end);
+			trace.startsolid = trace.ent != -1;
+		}
+		else {
+			trace = PM_PlayerTrace(end, end);
+		}
+		if (!trace.startsolid) pmove->origin = end;
+	}
+
+	// hl's stuck table in hl's axes, tiny nudges for precision errors first then the bigger ones
+	// made for the 32x32x72 hull, PM_CheckStuck scales them to the hull in use
+	// built once, with the zero offset and the repeats hl had in there left out
+	const NyaVec3Double STUCK_TABLE_HULL = { 16, 16, 36 };
+
+	std::vector<NyaVec3Double> BuildStuckTable() {
+		std::vector<NyaVec3Double> table;
+		auto add = [&table](double x, double y, double z) {
+			if (x == 0 && y == 0 && z == 0) return;
+			for (auto& offset : table) {
+				if (offset.x == x && offset.y == y && offset.z == z) return;
+			}
+			table.push_back({ x, y, z });
+		};
+
+		// Little Moves.
+		for (double z = -0.125; z <= 0.125; z += 0.125) add(0, 0, z);
+		for (double y = -0.125; y <= 0.125; y += 0.125) add(0, y, 0);
+		for (double x = -0.125; x <= 0.125; x += 0.125) add(x, 0, 0);
+
+		// Remaining multi axis nudges.
+		for (double x = -0.125; x <= 0.125; x += 0.250) {
+			for (double y = -0.125; y <= 0.125; y += 0.250) {
+				for (double z = -0.125; z <= 0.125; z += 0.250) {
+					add(x, y, z);
+				}
+			}
+		}
+
+		// Big Moves.
+		const double zi[3] = { 0, 1, 6 };
+		for (auto z : zi) add(0, 0, z);
+		for (double y = -2; y <= 2; y += 2) add(0, y, 0);
+		for (double x = -2; x <= 2; x += 2) add(x, 0, 0);
+
+		// Remaining multi axis nudges.
+		for (auto z : zi) {
+			for (double x = -2; x <= 2; x += 2) {
+				for (double y = -2; y <= 2; y += 2) {
+					add(x, y, z);
+				}
+			}
+		}
+		return table;
+	}
+	const auto aStuckTable = BuildStuckTable();
+
+	const double PM_CHECKSTUCK_MINTIME = 0.05; // seconds between goes through the table while there's no way out
+
+	bool PM_TestPlayerPosition(const NyaVec3Double& origin) {
+		FREEMANAPI_STAT_INC(numStuckTests);
+		if (IsUsingPlayerTraceFallback()) return TestBBoxWithRays(origin);
+		auto trace = PM_PlayerTrace(origin, origin);
+		return trace.startsolid || trace.allsolid;
+	}
+
+	// only runs after a trace from the player's position came back solid, otherwise there's nothing to fix
+	// tries the nudge that got the player out last time before going through the table
+	// returns true if there's no way out, the player then stays put for the substep
+	bool PM_CheckStuck() {
+		if (!pmove->bStuckCheck) return false;
+		FREEMANAPI_STAT_INC(numStuckChecks);
+
+		// If position is okay, exit
+		pmove->bStuckCheck = PM_TestPlayerPosition(pmove->origin);
+		if (!pmove->bStuckCheck) return false;
+
+		// Too soon?
+		if (pmove->flSimTime < pmove->flStuckTime + PM_CHECKSTUCK_MINTIME) return true;
+
+		auto hull = GetPlayerHullID();
+		auto half = (pmove->player_maxs[hull] - pmove->player_mins[hull]) * 0.5;
+		int axes[3] = { (UP + 1) % 3, (UP + 2) % 3, UP };
+		NyaVec3Double scale;
+		for (int i = 0; i < 3; i++) {
+			scale[axes[i]] = std::abs(half[axes[i]]) / STUCK_TABLE_HULL[i];
+		}
+
+		auto base = pmove->origin;
+		int numOffsets = aStuckTable.size();
+		int last = pmove->iStuckOffset;
+		for (int i = -1; i < numOffsets; i++) {
+			int id = i < 0 ? last : i;
+			if (id < 0 || id >= numOffsets || (i >= 0 && id == last)) continue;
+
+			auto test = base;
+			for (int j = 0; j < 3; j++) {
+				test[axes[j]] += aStuckTable[id][j] * scale[axes[j]];
+			}
+			if (!PM_TestPlayerPosition(test)) {
+				pmove->origin = test;
+				pmove->iStuckOffset = id;
+				pmove->bStuckCheck = false;
+				return false;
+			}
+		}
+
+		// leave the flag up so the next substep tries again
+		pmove->bStuckCheck = true;
+		pmove->flStuckTime = pmove->flSimTime;
+		lastConsoleMsg = "stuck";
+		FREEMANAPI_STAT_INC(numStuck);
+		return true;
+	}
+
 	void PM_PlayerMove(double delta) {
-		physent_t *pLadder = nullptr;
+		int ladder = -1;
+
+		FREEMANAPI_STAT_INC(numSubsteps);
+		FREEMANAPI_TIMELINE_SCOPE("PM_PlayerMove");
+
+		// the host's water can move between substeps
+		waterSurfaceCache.valid = false;
 
 		// Adjust speeds etc.
 		PM_CheckParamters();
 
-		// Assume we don't touch anything
-		//pmove->numtouch = 0;
-
 		// # of msec to apply movement
 		pmove->frametime = delta;
 		pmove->cmd.msec = pmove->frametime * 1000;
@@ -3069,8 +3955,11 @@ namespace FreemanAPI {
 		AngleVectors(pmove->angles, pmove->forward, pmove->right, pmove->up);
 
 		// Always try and unstick us unless we are in NOCLIP mode
-		/*if (pmove->movetype != MOVETYPE_NOCLIP && pmove->movetype != MOVETYPE_NONE) {
+		if (pmove->movetype != MOVETYPE_NOCLIP && pmove->movetype != MOVETYPE_NONE) {
 			if (PM_CheckStuck()) {
+				// hl2 doesn't let the player duck out of it
+				if (bHL2Mode) return;
+
 				// Let the user try to duck to get unstuck
 				PM_Duck();
 
@@ -3078,11 +3967,13 @@ namespace FreemanAPI {
 					return;  // Can't move, we're stuck
 				}
 			}
-		}*/
+		}
 
 		// Now that we are "unstuck", see where we are ( waterlevel and type, pmove->onground ).
 		PM_CatagorizePosition();
 
+		PM_UpdateBaseVelocity();
+
 		// Store off the starting water level
 		pmove->oldwaterlevel = pmove->waterlevel;
 
@@ -3091,14 +3982,12 @@ namespace FreemanAPI {
 			pmove->flFallVelocity = -pmove->velocity[UP];
 		}
 
-		// todo
-		//g_onladder = 0;
-		//// Don't run ladder code if dead or on a train
-		//if (!pmove->dead && !(pmove->flags & FL_ONTRAIN)) {
-		//	if (pLadder = PM_Ladder()) {
-		//		g_onladder = 1;
-		//	}
-		//}
+		bOnLadder = false;
+		// Don't run ladder code if dead or on a train
+		if (!pmove->dead && !(pmove->flags & FL_ONTRAIN)) {
+			ladder = PM_Ladder();
+			bOnLadder = ladder >= 0;
+		}
 
 		PM_UpdateStepSound();
 
@@ -3110,18 +3999,17 @@ namespace FreemanAPI {
 			PM_Duck();
 		}
 
-		// todo
-		// Don't run ladder code if dead or on a train
-		//if (!pmove->dead && !(pmove->flags & FL_ONTRAIN)) {
-		//	if (pLadder) {
-		//		PM_LadderMove(pLadder);
-		//	}
-		//	else if (pmove->movetype != MOVETYPE_WALK && pmove->movetype != MOVETYPE_NOCLIP) {
-		//		// Clear ladder stuff unless player is noclipping
-		//		//  it will be set immediately again next frame if necessary
-		//		pmove->movetype = MOVETYPE_WALK;
-		//	}
-		//}
+		if (ladder >= 0) {
+			PM_LadderMove(ladder);
+		}
+		else if (pmove->iLadder >= 0) {
+			// Clear ladder stuff unless player is noclipping
+			//  it will be set immediately again next frame if necessary
+			// only undoes what the ladder did, a host picked movetype stays
+			if (pmove->movetype == MOVETYPE_FLY) pmove->movetype = MOVETYPE_WALK;
+			pmove->iLadder = -1;
+			pmove->gravity = 1;
+		}
 
 		// Handle movement
 		switch (pmove->movetype) {
@@ -3152,7 +4040,7 @@ namespace FreemanAPI {
 				// If so, set velocity to 270 away from ladder.  This is currently wrong.
 				// Also, set MOVE_TYPE to walk, too.
 				if (pmove->cmd.buttons & IN_JUMP) {
-					if (!pLadder) {
+					if (ladder < 0) {
 						PM_Jump();
 					}
 				} else {
@@ -3218,7 +4106,7 @@ namespace FreemanAPI {
 					}
 					else {
 						if (pmove->cmd.buttons & IN_JUMP) {
-							if (!pLadder) {
+							if (ladder < 0) {
 								PM_Jump();
 							}
 						} else {
@@ -3239,14 +4127,6 @@ namespace FreemanAPI {
 					// Are we on ground now
 					if (pmove->onground != -1) {
 						PM_WalkMove();
-
-						// basic col check to get us unstuck due to point raytrace inaccuracy
-						if (IsUsingPlayerTraceFallback()) {
-							auto collide = GetClosestBBoxIntersection(pmove->origin, pmove->origin);
-							if (collide.ent != -1) {
-								pmove->origin = collide.endpos;
-							}
-						}
 					} else {
 						PM_AirMove();  // Take into account movement when in air.
 					}
@@ -3299,28 +4179,10 @@ namespace FreemanAPI {
 		return !(pmove->m_bDucked && !pmove->m_bDucking) && (pmove->waterlevel != 3);
 	}
 
-	void SetupMoveParams() {
-		movevars->gravity = bHL2Mode ? CVar_HL2::sv_gravity : CVar_HL1::sv_gravity;  			// Gravity for map
-		movevars->stopspeed = bHL2Mode ? CVar_HL2::sv_stopspeed : CVar_HL1::sv_stopspeed;			// Deceleration when not moving
-		movevars->maxspeed = bHL2Mode ? CVar_HL2::sv_maxspeed : CVar_HL1::sv_maxspeed; 			// Max allowed speed
-		movevars->accelerate = bHL2Mode ? CVar_HL2::sv_accelerate : CVar_HL1::sv_accelerate;			// Acceleration factor
-		movevars->airaccelerate = bHL2Mode ? CVar_HL2::sv_airaccelerate : CVar_HL1::sv_airaccelerate;		// Same for when in open air
-		movevars->wateraccelerate = bHL2Mode ? CVar_HL2::sv_wateraccelerate : CVar_HL1::sv_wateraccelerate;		// Same for when in water
-		movevars->friction = bHL2Mode ? CVar_HL2::sv_friction : CVar_HL1::sv_friction;
-		movevars->edgefriction = bHL2Mode ? CVar_HL2::sv_edgefriction : CVar_HL1::sv_edgefriction;
-		movevars->waterfriction = bHL2Mode ? CVar_HL2::sv_waterfriction : CVar_HL1::sv_waterfriction;		// Less in water
-		movevars->bounce = bHL2Mode ? CVar_HL2::sv_bounce : CVar_HL1::sv_bounce;      		// Wall bounce value. 1.0
-		movevars->stepsize = bHL2Mode ? CVar_HL2::sv_stepsize : CVar_HL1::sv_stepsize;
-		movevars->maxvelocity = bHL2Mode ? CVar_HL2::sv_maxvelocity : CVar_HL1::sv_maxvelocity; 		// maximum server velocity.
-		movevars->rollangle = bHL2Mode ? CVar_HL2::sv_rollangle : CVar_HL1::sv_rollangle;
-		movevars->rollspeed = bHL2Mode ? CVar_HL2::sv_rollspeed : CVar_HL1::sv_rollspeed;
-
-		// todo train velocity
-		pmove->basevelocity = {0,0,0};
-
-		pmove->gravity = 1;
-		pmove->friction = 1;
+	// view angles, movement and buttons into pmove->cmd, once per frame or before every substep with input events
+	void SetupMoveInput() {
 		GetGamePlayerViewAngle(&pmove->cmd.viewangles);
+		pmove->cmd.viewangles[YAW] += pmove->flCarriedYaw;
 		pmove->clientmaxspeed = movevars->maxspeed;
 		if (!bHL2Mode && pmove->movetype == MOVETYPE_NOCLIP) pmove->clientmaxspeed = CVar_HL1::sv_noclipspeed;
 		pmove->maxspeed = pmove->clientmaxspeed; // not sure what the difference is here? todo?
@@ -3340,15 +4202,15 @@ namespace FreemanAPI {
 		float sidespeed = bHL2Mode ? CVar_HL2::cl_sidespeed : CVar_HL1::cl_sidespeed;
 		float upspeed = bHL2Mode ? CVar_HL2::cl_upspeed : CVar_HL1::cl_upspeed;
 
-		static bool bLastSprinting = false;
+		auto& bLastSprinting = pmove->bLastSprinting;
 
-		if (EXT_GetGameMoveLeftRight) pmove->cmd.sidemove += sidespeed * EXT_GetGameMoveLeftRight();
-		if (EXT_GetGameMoveFwdBack) pmove->cmd.forwardmove += forwardspeed * EXT_GetGameMoveFwdBack();
-		if (EXT_GetGameMoveUpDown) pmove->cmd.upmove += upspeed * EXT_GetGameMoveUpDown();
-		if (EXT_GetGameMoveUse && EXT_GetGameMoveUse()) pmove->cmd.buttons |= IN_USE;
-		if (EXT_GetGameMoveJump && EXT_GetGameMoveJump()) pmove->cmd.buttons |= IN_JUMP;
-		if (EXT_GetGameMoveDuck && EXT_GetGameMoveDuck()) pmove->cmd.buttons |= IN_DUCK;
-		if (EXT_GetGameMoveRun && EXT_GetGameMoveRun()) {
+		pmove->cmd.sidemove += sidespeed * GetGameMoveLeftRight();
+		pmove->cmd.forwardmove += forwardspeed * GetGameMoveFwdBack();
+		pmove->cmd.upmove += upspeed * GetGameMoveUpDown();
+		if (GetGameMoveUse()) pmove->cmd.buttons |= IN_USE;
+		if (GetGameMoveJump()) pmove->cmd.buttons |= IN_JUMP;
+		if (GetGameMoveDuck()) pmove->cmd.buttons |= IN_DUCK;
+		if (GetGameMoveRun()) {
 			if (bHL2Mode) {
 				if (CanSprint()) {
 					pmove->m_bIsSprinting = true;
@@ -3378,9 +4240,49 @@ namespace FreemanAPI {
 		}
 	}
 
+	void SetupMoveParams() {
+		FREEMANAPI_TIMELINE_SCOPE("SetupMoveParams");
+
+		movevars->gravity = bHL2Mode ? CVar_HL2::sv_gravity : CVar_HL1::sv_gravity;  			// Gravity for map
+		movevars->stopspeed = bHL2Mode ? CVar_HL2::sv_stopspeed : CVar_HL1::sv_stopspeed;			// Deceleration when not moving
+		movevars->maxspeed = bHL2Mode ? CVar_HL2::sv_maxspeed : CVar_HL1::sv_maxspeed; 			// Max allowed speed
+		movevars->accelerate = bHL2Mode ? CVar_HL2::sv_accelerate : CVar_HL1::sv_accelerate;			// Acceleration factor
+		movevars->airaccelerate = bHL2Mode ? CVar_HL2::sv_airaccelerate : CVar_HL1::sv_airaccelerate;		// Same for when in open air
+		movevars->wateraccelerate = bHL2Mode ? CVar_HL2::sv_wateraccelerate : CVar_HL1::sv_wateraccelerate;		// Same for when in water
+		movevars->friction = bHL2Mode ? CVar_HL2::sv_friction : CVar_HL1::sv_friction;
+		movevars->edgefriction = bHL2Mode ? CVar_HL2::sv_edgefriction : CVar_HL1::sv_edgefriction;
+		movevars->waterfriction = bHL2Mode ? CVar_HL2::sv_waterfriction : CVar_HL1::sv_waterfriction;		// Less in water
+		movevars->bounce = bHL2Mode ? CVar_HL2::sv_bounce : CVar_HL1::sv_bounce;      		// Wall bounce value. 1.0
+		movevars->stepsize = bHL2Mode ? CVar_HL2::sv_stepsize : CVar_HL1::sv_stepsize;
+		movevars->maxvelocity = bHL2Mode ? CVar_HL2::sv_maxvelocity : CVar_HL1::sv_maxvelocity; 		// maximum server velocity.
+		movevars->rollangle = bHL2Mode ? CVar_HL2::sv_rollangle : CVar_HL1::sv_rollangle;
+		movevars->rollspeed = bHL2Mode ? CVar_HL2::sv_rollspeed : CVar_HL1::sv_rollspeed;
+
+		// water currents get added again by PM_CheckWater, the ground entity's share stays until PM_UpdateBaseVelocity swaps it
+		pmove->basevelocity = pmove->vecBaseEntVelocity;
+		pmove->basevelocity[UP] = 0;
+
+		pmove->gravity = 1;
+		pmove->friction = 1;
+	}
+
+	// eye position and angles in game space, either can be null
+	void GetView(NyaVec3Double* origin, NyaVec3Double* angles) {
+		auto& view = CalcView();
+		if (origin) {
+			*origin = view.origin;
+			if (bConvertUnits) {
+				for (int i = 0; i < 3; i++) {
+					(*origin)[i] = UnitsToMeters((*origin)[i]);
+				}
+				*origin *= vXYZUnitsMult;
+			}
+		}
+		if (angles) *angles = view.angles;
+	}
+
 	void ApplyMoveParams() {
-		auto eye = pmove->origin + pmove->view_ofs;
-		eye[UP] += V_CalcBob();
+		FREEMANAPI_TIMELINE_SCOPE("ApplyMoveParams");
 
 		auto origin = pmove->origin;
 		auto originRaw = origin;
@@ -3391,12 +4293,10 @@ namespace FreemanAPI {
 		//}
 		if (bConvertUnits) {
 			for (int i = 0; i < 3; i++) {
-				eye[i] = UnitsToMeters(eye[i]);
 				origin[i] = UnitsToMeters(origin[i]);
 				originRaw[i] = UnitsToMeters(originRaw[i]);
 				velocity[i] = UnitsToMeters(velocity[i]);
 			}
-			eye *= vXYZUnitsMult;
 			origin *= vXYZUnitsMult;
 			originRaw *= vXYZUnitsMult;
 			velocity *= vXYZUnitsMult;
@@ -3404,8 +4304,14 @@ namespace FreemanAPI {
 
 		SetGamePlayerPosition(&origin, &velocity);
 		SetGamePlayerPositionRaw(&originRaw, &velocity);
-		SetGamePlayerViewPosition(&eye);
-		SetGamePlayerViewAngle(&pmove->angles);
+
+		// hosts that don't take the view from the callbacks can get it with GetView, or not at all
+		if (EXT_SetGamePlayerViewPosition || EXT_SetGamePlayerViewAngle) {
+			NyaVec3Double eye, angles;
+			GetView(&eye, &angles);
+			SetGamePlayerViewPosition(&eye);
+			SetGamePlayerViewAngle(&angles);
+		}
 	}
 
 	void SetPlayerBBoxes() {
@@ -3432,6 +4338,16 @@ namespace FreemanAPI {
 	}
 
 	void Reset() {
+		if (IsRecordingReplay()) {
+			tReplayRecord record;
+			record.AddInt(nRandomSeed);
+			record.AddInt(nDefaultMoveType);
+			replayWriter.Write(REPLAY_RESET, record);
+		}
+
+		// the mode may have changed since the last frame, and the swap check in Process is skipped after a reset
+		SetPlayerBBoxes();
+
 		NyaVec3Double gamePlayer, gameVelocity;
 		GetGamePlayerPosition(&gamePlayer);
 		GetGamePlayerVelocity(&gameVelocity);
@@ -3452,6 +4368,12 @@ namespace FreemanAPI {
 		pmove->cmd.viewangles = {0,0,0};
 		pmove->punchangle = {0,0,0};
 		pmove->basevelocity = {0,0,0};
+		pmove->iBaseEnt = -1;
+		pmove->vecBaseEntVelocity = {0,0,0};
+		pmove->bStuckCheck = true;
+		pmove->iStuckOffset = -1;
+		pmove->flStuckTime = -INFINITY;
+		pmove->flCarriedYaw = 0;
 		pmove->movedir = {0,0,0};
 		pmove->onground = -1;
 		pmove->movetype = nDefaultMoveType;
@@ -3468,6 +4390,16 @@ namespace FreemanAPI {
 		pmove->iStepLeft = 0;
 		pmove->flFallVelocity = 0;
 		pmove->flSwimTime = 0;
+		pmove->iSkipStep = 0;
+		pmove->random.Seed(nRandomSeed);
+		pmove->bLastHL2 = bHL2Mode;
+		GetContext()->history.Clear();
+		GetContext()->view = {};
+		GetContext()->view.simTime = pmove->flSimTime;
+		for (auto& lod : pmove->colLod) {
+			lod = {};
+		}
+		pmove->iLadder = -1;
 		pmove->flags = 0;
 		pmove->gravity = 1;
 		pmove->friction = 1;
@@ -3529,25 +4461,389 @@ namespace FreemanAPI {
 		pmove->origin[UP] -= GetPlayerCenterUp();
 	}
 
+	void BeginFrameBudget() {
+		if (bStatsPerFrame) ResetFrameStats();
+		fBudgetFrameStart = GetProfileMicros();
+	}
+
+	// returns the new substep count for this frame, lowered if the remaining substeps would go over budget
+	int UpdateFrameBudget(int stepsDone, int numSteps) {
+		// replays take the budget decisions from the log, the timings they were made on aren't reproducible
+		if (replayReader.IsActive()) {
+			if (replayReader.PeekTag() != REPLAY_STEPS) return numSteps;
+			auto& record = replayReader.Read(REPLAY_STEPS);
+			nBudgetQualityLevel = record.GetInt(1);
+			return record.GetInt(0);
+		}
+
+		if (nFrameBudgetMicros <= 0 || bBudgetHeld || stepsDone >= numSteps) return numSteps;
+
+		double elapsed = GetProfileMicros() - fBudgetFrameStart;
+		double projected = elapsed + (elapsed / stepsDone) * (numSteps - stepsDone);
+		if (projected <= nFrameBudgetMicros) return numSteps;
+
+		if (nBudgetQualityLevel < BUDGET_MAX_QUALITY_LEVEL) {
+			nBudgetQualityLevel++;
+			stats.numBudgetDegrades++;
+		}
+		nBudgetCalmFrames = 0;
+
+		int stepsLeft = numSteps - stepsDone;
+		stepsLeft = nBudgetQualityLevel >= BUDGET_MAX_QUALITY_LEVEL ? 1 : (stepsLeft + 1) / 2;
+		if (IsRecordingReplay()) {
+			tReplayRecord record;
+			record.AddInt(stepsDone + stepsLeft);
+			record.AddInt(nBudgetQualityLevel);
+			replayWriter.Write(REPLAY_STEPS, record);
+		}
+		return stepsDone + stepsLeft;
+	}
+
+	void EndFrameBudget() {
+		float frameMicros = GetProfileMicros() - fBudgetFrameStart;
+		stats.numFrames++;
+		stats.lastFrameMicros = frameMicros;
+		stats.maxFrameMicros = std::max(stats.maxFrameMicros, frameMicros);
+		stats.avgCollisionRaysPerFrame = bStatsPerFrame ? stats.numCollisionRays : (float)stats.numCollisionRays / stats.numFrames;
+		if (bBudgetHeld) return;
+
+		if (nFrameBudgetMicros <= 0) {
+			nBudgetQualityLevel = 0;
+			nBudgetCalmFrames = 0;
+		}
+		else if (frameMicros > nFrameBudgetMicros) {
+			stats.numBudgetOverruns++;
+			nBudgetCalmFrames = 0;
+		}
+		// a level up roughly doubles the cost, so only restore once we've been under half the budget for a while
+		else if (nBudgetQualityLevel > 0 && frameMicros < nFrameBudgetMicros * 0.5) {
+			if (++nBudgetCalmFrames >= BUDGET_RESTORE_FRAMES) {
+				nBudgetQualityLevel--;
+				nBudgetCalmFrames = 0;
+				stats.numBudgetRestores++;
+			}
+		}
+		else {
+			nBudgetCalmFrames = 0;
+		}
+		stats.budgetQualityLevel = nBudgetQualityLevel;
+	}
+
+	void RecordReplayFrame(double delta) {
+		if (!IsRecordingReplay()) return;
+
+		replayWriter.WriteConfigIfChanged();
+
+		// volumes added before the recording started have a revision too, so they get logged up front
+		if (replayWriter.lastWaterRevision != nWaterRevision) {
+			std::vector<uint8_t> water;
+			SerializeWaterVolumes(water);
+			replayWriter.PutBlob(REPLAY_WATER, water.data(), water.size());
+			replayWriter.lastWaterRevision = nWaterRevision;
+		}
+		if (replayWriter.lastLadderRevision != nLadderRevision) {
+			std::vector<uint8_t> ladders;
+			SerializeLadders(ladders);
+			replayWriter.PutBlob(REPLAY_LADDERS, ladders.data(), ladders.size());
+			replayWriter.lastLadderRevision = nLadderRevision;
+		}
+
+		tReplayRecord record;
+		record.AddDouble(delta);
+		record.AddInt(nBudgetQualityLevel);
+		record.AddInt(pmove->movetype);
+		replayWriter.Write(REPLAY_FRAME, record);
+	}
+
+	// the end result of every frame goes into the log too, so a replay can tell exactly where it starts to differ
+	void RecordReplayOutput() {
+		if (!IsRecordingReplay() && !replayReader.IsActive()) return;
+
+		tReplayRecord record;
+		record.AddVector(pmove->origin);
+		record.AddVector(pmove->velocity);
+		record.AddVector(pmove->angles);
+		if (IsRecordingReplay()) {
+			replayWriter.Write(REPLAY_OUTPUT, record);
+		}
+		else if (replayReader.PeekTag() == REPLAY_OUTPUT) {
+			auto& recorded = replayReader.Read(REPLAY_OUTPUT);
+			if (memcmp(recorded.values, record.values, sizeof(record.values))) {
+				if (!replayReader.numOutputMismatches) replayReader.firstOutputMismatch = replayReader.numFrames;
+				replayReader.numOutputMismatches++;
+			}
+		}
+	}
+
+	// replay versions of the host callbacks, everything comes from the log
+	bool ReplayGetGamePlayerDead() {
+		return replayReader.Read(REPLAY_DEAD).GetInt(0);
+	}
+	void ReplayGetGamePlayerVector(int tag, double* out) {
+		auto& record = replayReader.Read(tag);
+		for (int i = 0; i < 3; i++) {
+			out[i] = record.GetDouble(i);
+		}
+	}
+	void ReplayGetGamePlayerPosition(double* out) { ReplayGetGamePlayerVector(REPLAY_POSITION, out); }
+	void ReplayGetGamePlayerVelocity(double* out) { ReplayGetGamePlayerVector(REPLAY_VELOCITY, out); }
+	void ReplayGetGamePlayerViewAngle(double* out) { ReplayGetGamePlayerVector(REPLAY_VIEWANGLE, out); }
+	int ReplayGetPointContents(const double*) {
+		return replayReader.Read(REPLAY_POINTCONTENTS).GetInt(0);
+	}
+	float ReplayGetStepHeight(const double*, const double*) { return replayReader.Read(REPLAY_STEPHEIGHT).GetFloat(0); }
+	bool ReplayGetEntityVelocity(int, double* origin, double* velocity, double* angular) {
+		auto& record = replayReader.Read(REPLAY_ENTITYVELOCITY);
+		for (int i = 0; i < 3; i++) {
+			origin[i] = record.GetDouble(1 + i);
+			velocity[i] = record.GetDouble(4 + i);
+			angular[i] = record.GetDouble(7 + i);
+		}
+		return record.GetInt(0);
+	}
+	double ReplayGetWaterSurfaceHeight(const double*, int* contents) {
+		auto& record = replayReader.Read(REPLAY_WATERSURFACE);
+		*contents = record.GetInt(1);
+		return record.GetDouble(0);
+	}
+	pmtrace_t* ReplayTrace(int tag, const double* end) {
+		static FREEMANAPI_THREAD_LOCAL pmtrace_t trace;
+		NyaVec3Double endVec = { end[0], end[1], end[2] };
+		replayReader.ReadTrace(tag, &trace, &endVec);
+		return &trace;
+	}
+	pmtrace_t* ReplayPointRaytrace(const double*, const double* end) { return ReplayTrace(REPLAY_POINTRAYTRACE, end); }
+	pmtrace_t* ReplayPM_PlayerTrace(const double*, const double* end) { return ReplayTrace(REPLAY_PLAYERTRACE, end); }
+	pmtrace_t* ReplayPM_PlayerTraceDown(const double*, const double* end) { return ReplayTrace(REPLAY_PLAYERTRACEDOWN, end); }
+	float ReplayGetGameMoveLeftRight() { return replayReader.Read(REPLAY_MOVE_LEFTRIGHT).GetFloat(0); }
+	float ReplayGetGameMoveFwdBack() { return replayReader.Read(REPLAY_MOVE_FWDBACK).GetFloat(0); }
+	float ReplayGetGameMoveUpDown() { return replayReader.Read(REPLAY_MOVE_UPDOWN).GetFloat(0); }
+	bool ReplayGetGameMoveJump() { return replayReader.Read(REPLAY_MOVE_JUMP).GetInt(0); }
+	bool ReplayGetGameMoveDuck() { return replayReader.Read(REPLAY_MOVE_DUCK).GetInt(0); }
+	bool ReplayGetGameMoveRun() { return replayReader.Read(REPLAY_MOVE_RUN).GetInt(0); }
+	bool ReplayGetGameMoveUse() { return replayReader.Read(REPLAY_MOVE_USE).GetInt(0); }
+
+	// input that's already known instead of polled, Rollback's inputs or the queued input events
+	FREEMANAPI_THREAD_LOCAL const FreemanInputFrame* pBufferedInput = nullptr;
+
+	void BufferedGetGamePlayerViewAngle(double* out) {
+		out[0] = pBufferedInput->viewAngles[0];
+		out[1] = pBufferedInput->viewAngles[1];
+		out[2] = pBufferedInput->viewAngles[2];
+	}
+	float BufferedGetGameMoveLeftRight() { return pBufferedInput->leftRight; }
+	float BufferedGetGameMoveFwdBack() { return pBufferedInput->fwdBack; }
+	float BufferedGetGameMoveUpDown() { return pBufferedInput->upDown; }
+	bool BufferedGetGameMoveJump() { return pBufferedInput->jump; }
+	bool BufferedGetGameMoveDuck() { return pBufferedInput->duck; }
+	bool BufferedGetGameMoveRun() { return pBufferedInput->run; }
+	bool BufferedGetGameMoveUse() { return pBufferedInput->use; }
+
+	void SetBufferedInputCallbacks(tGameCallbacks& callbacks) {
+		callbacks.GetGamePlayerViewAngle = BufferedGetGamePlayerViewAngle;
+		callbacks.GetGameMoveLeftRight = BufferedGetGameMoveLeftRight;
+		callbacks.GetGameMoveFwdBack = BufferedGetGameMoveFwdBack;
+		callbacks.GetGameMoveUpDown = BufferedGetGameMoveUpDown;
+		callbacks.GetGameMoveJump = BufferedGetGameMoveJump;
+		callbacks.GetGameMoveDuck = BufferedGetGameMoveDuck;
+		callbacks.GetGameMoveRun = BufferedGetGameMoveRun;
+		callbacks.GetGameMoveUse = BufferedGetGameMoveUse;
+	}
+
+	FREEMANAPI_THREAD_LOCAL FreemanInputFrame sliceInput; // what the current substep sees, button taps shorter than a substep still count
+	FREEMANAPI_THREAD_LOCAL tGameCallbacks inputEventCallbacks; // the host's, while the buffered ones stand in for them
+
+	// true if this frame takes its input from the queued events, the input then gets set up again before every substep that has some
+	// replays don't have the events, they just log that the frame and its substeps used them and read back what the substeps saw
+	// all of the input callbacks are read back then, the buffered ones stand in even for types the host has no callback for
+	bool BeginInputEvents() {
+		if (replayReader.IsActive()) {
+			if (replayReader.PeekTag() != REPLAY_INPUTEVENTS) return false;
+			replayReader.Read(REPLAY_INPUTEVENTS);
+
+			inputEventCallbacks.Save();
+			auto callbacks = inputEventCallbacks;
+			callbacks.GetGamePlayerViewAngle = ReplayGetGamePlayerViewAngle;
+			callbacks.GetGameMoveLeftRight = ReplayGetGameMoveLeftRight;
+			callbacks.GetGameMoveFwdBack = ReplayGetGameMoveFwdBack;
+			callbacks.GetGameMoveUpDown = ReplayGetGameMoveUpDown;
+			callbacks.GetGameMoveJump = ReplayGetGameMoveJump;
+			callbacks.GetGameMoveDuck = ReplayGetGameMoveDuck;
+			callbacks.GetGameMoveRun = ReplayGetGameMoveRun;
+			callbacks.GetGameMoveUse = ReplayGetGameMoveUse;
+			callbacks.Restore();
+			return true;
+		}
+
+		auto& events = GetContext()->inputEvents;
+		if (!events.mask || pBufferedInput) return false;
+
+		// whatever the host doesn't send events for is still polled, once per frame
+		// straight from the callbacks, the buffered values are what goes into replays
+		auto& state = events.state;
+		if (!(events.mask & (1 << INPUT_EVENT_VIEWANGLES))) {
+			state.viewAngles[0] = state.viewAngles[1] = state.viewAngles[2] = 0;
+			if (EXT_GetGamePlayerViewAngle) EXT_GetGamePlayerViewAngle(state.viewAngles);
+		}
+		if (!(events.mask & (1 << INPUT_EVENT_FWDBACK))) state.fwdBack = EXT_GetGameMoveFwdBack ? EXT_GetGameMoveFwdBack() : 0;
+		if (!(events.mask & (1 << INPUT_EVENT_LEFTRIGHT))) state.leftRight = EXT_GetGameMoveLeftRight ? EXT_GetGameMoveLeftRight() : 0;
+		if (!(events.mask & (1 << INPUT_EVENT_UPDOWN))) state.upDown = EXT_GetGameMoveUpDown ? EXT_GetGameMoveUpDown() : 0;
+		if (!(events.mask & (1 << INPUT_EVENT_JUMP))) state.jump = EXT_GetGameMoveJump && EXT_GetGameMoveJump();
+		if (!(events.mask & (1 << INPUT_EVENT_DUCK))) state.duck = EXT_GetGameMoveDuck && EXT_GetGameMoveDuck();
+		if (!(events.mask & (1 << INPUT_EVENT_RUN))) state.run = EXT_GetGameMoveRun && EXT_GetGameMoveRun();
+		if (!(events.mask & (1 << INPUT_EVENT_USE))) state.use = EXT_GetGameMoveUse && EXT_GetGameMoveUse();
+
+		if (IsRecordingReplay()) {
+			tReplayRecord record;
+			record.AddInt(events.mask);
+			replayWriter.Write(REPLAY_INPUTEVENTS, record);
+		}
+
+		inputEventCallbacks.Save();
+		auto callbacks = inputEventCallbacks;
+		SetBufferedInputCallbacks(callbacks);
+		callbacks.Restore();
+		sliceInput = state;
+		pBufferedInput = &sliceInput;
+		return true;
+	}
+
+	// applies every event before the end of the substep's slice of the frame, then sets up the input again if it changed
+	// the movement code scales the command in place while ducking or using, so a substep with nothing new keeps it like a polled frame does
+	// replays don't know which substeps had events, the ones after the first log it
+	void ApplyInputEvents(double sliceEnd, bool firstSlice) {
+		bool changed = firstSlice;
+		if (replayReader.IsActive()) {
+			if (!firstSlice && replayReader.PeekTag() == REPLAY_INPUTEVENTS) {
+				replayReader.Read(REPLAY_INPUTEVENTS);
+				changed = true;
+			}
+		}
+		else {
+			auto& events = GetContext()->inputEvents;
+			auto& state = events.state;
+			int numApplied = 0;
+			bool jump = false, duck = false, use = false;
+			for (auto& event : events.queue) {
+				if (event.time >= sliceEnd) break;
+				numApplied++;
+
+				bool down = event.value[0] != 0;
+				switch (event.type) {
+					case INPUT_EVENT_FWDBACK:
+						state.fwdBack = event.value[0];
+						break;
+					case INPUT_EVENT_LEFTRIGHT:
+						state.leftRight = event.value[0];
+						break;
+					case INPUT_EVENT_UPDOWN:
+						state.upDown = event.value[0];
+						break;
+					case INPUT_EVENT_JUMP:
+						state.jump = down;
+						jump |= down;
+						break;
+					case INPUT_EVENT_DUCK:
+						state.duck = down;
+						duck |= down;
+						break;
+					case INPUT_EVENT_RUN:
+						state.run = down;
+						break;
+					case INPUT_EVENT_USE:
+						state.use = down;
+						use |= down;
+						break;
+					case INPUT_EVENT_VIEWANGLES:
+						for (int i = 0; i < 3; i++) {
+							state.viewAngles[i] = event.value[i];
+						}
+						break;
+				}
+			}
+			events.queue.erase(events.queue.begin(), events.queue.begin() + numApplied);
+			FREEMANAPI_STAT_ADD(numInputEvents, numApplied);
+
+			// a tap from the last slice is over now too
+			changed |= numApplied || sliceInput.jump != state.jump || sliceInput.duck != state.duck || sliceInput.use != state.use;
+			sliceInput = state;
+			sliceInput.jump |= jump;
+			sliceInput.duck |= duck;
+			sliceInput.use |= use;
+
+			if (changed && !firstSlice && IsRecordingReplay()) {
+				tReplayRecord record;
+				record.AddInt(events.mask);
+				replayWriter.Write(REPLAY_INPUTEVENTS, record);
+			}
+		}
+		if (changed) SetupMoveInput();
+	}
+
+	// events past the end of the frame move up to the start of the next one
+	void EndInputEvents(double delta) {
+		inputEventCallbacks.Restore();
+		if (replayReader.IsActive()) return;
+
+		for (auto& event : GetContext()->inputEvents.queue) {
+			event.time -= delta;
+		}
+		pBufferedInput = nullptr;
+	}
+
 	void Process(double delta) {
-		static bool bLastHL2 = bHL2Mode;
-		if (bLastHL2 != bHL2Mode) {
+		FREEMANAPI_TIMELINE_SCOPE("Process");
+		FREEMANAPI_LATENCY_SCOPE(histProcess);
+		RecordReplayFrame(delta);
+		BeginFrameBudget();
+
+		if (pmove->bLastHL2 != bHL2Mode) {
 			ResetForHL2Swap();
 		}
-		bLastHL2 = bHL2Mode;
+		pmove->bLastHL2 = bHL2Mode;
 
+		bool bInputEvents = BeginInputEvents();
 		SetupMoveParams();
+		// with input events the substeps set up their own input, see ApplyInputEvents
+		if (!bInputEvents) SetupMoveInput();
+
+		// Assume we don't touch anything
+		GetContext()->touches.count = 0;
+		aEntityVelocities.clear();
 
 		SetPlayerBBoxes();
+		PM_RideBaseEntity(delta);
 		pmove->m_iSpeedCropped = SPEED_CROPPED_RESET;
 
-		int numSteps = nPhysicsSteps;
-		if (numSteps < 1) numSteps = 1;
-		for (int i = 0; i < nPhysicsSteps; i++) {
-			PM_PlayerMove(delta / (double)nPhysicsSteps);
+		int numSteps = GetPhysicsSteps();
+		double stepTime = delta / (double)numSteps;
+		double timeLeft = delta;
+		for (int i = 0; i < numSteps; i++) {
+			// the last slice ends at delta itself so rounding in timeLeft can't leave an event at the end of the frame behind
+			if (bInputEvents) ApplyInputEvents(i == numSteps - 1 ? delta : delta - timeLeft + stepTime, i == 0);
+			{
+				FREEMANAPI_LATENCY_SCOPE(histSubstep);
+				PM_PlayerMove(stepTime);
+			}
+			pmove->flSimTime += stepTime;
+			RecordHullHistory(GetPlayerHullID());
+			timeLeft -= stepTime;
+
+			int newNumSteps = UpdateFrameBudget(i + 1, numSteps);
+			if (newNumSteps != numSteps) {
+				// spread the rest of the frame over the remaining substeps
+				numSteps = newNumSteps;
+				stepTime = timeLeft / (double)(numSteps - i - 1);
+			}
 		}
 
+		if (bInputEvents) EndInputEvents(delta);
+
+		GetContext()->view.bDirty = true;
 		ApplyMoveParams();
+		RecordReplayOutput();
+
+		EndFrameBudget();
 	}
 
 	void FillConfig() {
@@ -3563,7 +4859,9 @@ namespace FreemanAPI {
 		}
 		if (aAdvancedConfig.empty()) {
 			AddIntToCustomConfig(&aAdvancedConfig, "Collision Density", "collision_density", &nColDensity);
+			AddBoolToCustomConfig(&aAdvancedConfig, "Adaptive Collision Density", "collision_density_adaptive", &bAdaptiveColDensity);
 			AddIntToCustomConfig(&aAdvancedConfig, "Physics Steps", "physics_steps", &nPhysicsSteps);
+			AddIntToCustomConfig(&aAdvancedConfig, "Frame Budget (us)", "frame_budget_us", &nFrameBudgetMicros);
 		}
 		if (aCVarConfigHL1.empty()) {
 			AddFloatToCustomConfig(&aCVarConfigHL1, "cl_bob", "cl_bob", &CVar_HL1::cl_bob);
@@ -3685,8 +4983,31 @@ namespace FreemanAPI {
 			DrawMenuOption(std::format("Velocity - {:.2f} {:.2f} {:.2f}", pmove->velocity[0], pmove->velocity[1], pmove->velocity[2]));
 			DrawMenuOption(std::format("Punch Angle - {:.2f} {:.2f} {:.2f}", pmove->punchangle[0], pmove->punchangle[1], pmove->punchangle[2]));
 			DrawMenuOption(std::format("View Angle - {:.2f} {:.2f} {:.2f}", pmove->angles[0], pmove->angles[1], pmove->angles[2]));
-			DrawMenuOption(std::format("Last Plane Normal - {:.2f}", fLastPlaneNormal));
+			DrawMenuOption(std::format("Last Plane Normal - {:.2f}", pmove->flLastPlaneNormal));
 			DrawMenuOption(std::format("On Ground - {}", pmove->onground));
+			DrawMenuOption(std::format("Frame Time - {:.1f}us", stats.lastFrameMicros));
+			DrawMenuOption(std::format("Budget Quality Level - {}", nBudgetQualityLevel));
+			DrawMenuOption(std::format("Collision Rays / Frame - {:.1f}", stats.avgCollisionRaysPerFrame));
+			if (DrawMenuOption("Latency")) {
+				ChloeMenuLib::BeginMenu();
+				FreemanLatencyStats latency;
+				GetLatencyStats(&latency);
+				std::pair<const char*, FreemanLatency*> aLatencies[] = {
+					{ "Process", &latency.process },
+					{ "Substep", &latency.substep },
+					{ "PlayerTrace", &latency.playerTrace },
+					{ "PointRaytrace", &latency.pointRaytrace },
+					{ "PointContents", &latency.pointContents },
+				};
+				for (auto& it : aLatencies) {
+					auto& value = *it.second;
+					DrawMenuOption(std::format("{} - {:.1f} / {:.1f} / {:.1f} / {:.1f} / {:.1f}us", it.first, value.p50, value.p90, value.p99, value.p999, value.max), "p50 / p90 / p99 / p99.9 / max");
+				}
+				if (DrawMenuOption("Reset", "Clear the latency histograms")) {
+					ResetLatencyStats();
+				}
+				ChloeMenuLib::EndMenu();
+			}
 			DrawMenuOption(lastConsoleMsg);
 			ChloeMenuLib::EndMenu();
 		}
@@ -3723,4 +5044,245 @@ namespace FreemanAPI {
 			value.ReadFromConfig(config, "cvars");
 		}
 	}
+
+	// which callbacks the simulation would actually call right now, the replay has to make the same choices
+	uint32_t GetReplayCallbackMask() {
+		uint32_t mask = 0;
+		if (EXT_GetGamePlayerDead) mask |= 1 << REPLAY_DEAD;
+		if (EXT_GetGamePlayerPosition) mask |= 1 << REPLAY_POSITION;
+		if (EXT_GetGamePlayerVelocity) mask |= 1 << REPLAY_VELOCITY;
+		if (EXT_GetGamePlayerViewAngle) mask |= 1 << REPLAY_VIEWANGLE;
+		if (EXT_GetGameMoveLeftRight) mask |= 1 << REPLAY_MOVE_LEFTRIGHT;
+		if (EXT_GetGameMoveFwdBack) mask |= 1 << REPLAY_MOVE_FWDBACK;
+		if (EXT_GetGameMoveUpDown) mask |= 1 << REPLAY_MOVE_UPDOWN;
+		if (EXT_GetGameMoveJump) mask |= 1 << REPLAY_MOVE_JUMP;
+		if (EXT_GetGameMoveDuck) mask |= 1 << REPLAY_MOVE_DUCK;
+		if (EXT_GetGameMoveRun) mask |= 1 << REPLAY_MOVE_RUN;
+		if (EXT_GetGameMoveUse) mask |= 1 << REPLAY_MOVE_USE;
+		if (EXT_GetPointContents) mask |= 1 << REPLAY_POINTCONTENTS;
+		if (EXT_GetStepHeight) mask |= 1 << REPLAY_STEPHEIGHT;
+		if (EXT_GetWaterSurfaceHeight) mask |= 1 << REPLAY_WATERSURFACE;
+		if (EXT_GetEntityVelocity) mask |= 1 << REPLAY_ENTITYVELOCITY;
+		if (EXT_PointRaytrace || EXT_PointRaytraceBatch || EXT_PM_PlayerTrace) mask |= 1 << REPLAY_POINTRAYTRACE;
+		if (EXT_PM_PlayerTrace) mask |= 1 << REPLAY_PLAYERTRACE;
+		if (EXT_PM_PlayerTraceDown || EXT_PM_PlayerTrace) mask |= 1 << REPLAY_PLAYERTRACEDOWN;
+		return mask;
+	}
+
+	bool StartRecording(const char* path) {
+		if (!path || replayReader.IsActive()) return false;
+		if (aBehaviorConfig.empty()) FillConfig();
+		return replayWriter.Start(path, GetReplayCallbackMask());
+	}
+
+	void StopRecording() {
+		replayWriter.Stop();
+	}
+
+	// re-simulates the opened log without touching the host, all settings and state are put back afterwards
+	bool RunReplay(FreemanReplayResult* out) {
+		if (aBehaviorConfig.empty()) FillConfig();
+
+		tGameCallbacks savedCallbacks;
+		savedCallbacks.Save();
+		std::vector<uint8_t> savedConfig;
+		SerializeReplayConfig(savedConfig);
+		auto savedState = *pmove;
+		auto savedHistory = GetContext()->history;
+		auto savedView = GetContext()->view;
+		auto savedWaterVolumes = aWaterVolumes;
+		auto savedLadders = aLadders;
+		auto savedRandomSeed = nRandomSeed;
+		auto savedDefaultMoveType = nDefaultMoveType;
+		auto savedQualityLevel = nBudgetQualityLevel;
+		auto savedCalmFrames = nBudgetCalmFrames;
+
+		tGameCallbacks callbacks = {};
+		auto mask = replayReader.callbackMask;
+		if (mask & (1 << REPLAY_DEAD)) callbacks.GetGamePlayerDead = ReplayGetGamePlayerDead;
+		if (mask & (1 << REPLAY_POSITION)) callbacks.GetGamePlayerPosition = ReplayGetGamePlayerPosition;
+		if (mask & (1 << REPLAY_VELOCITY)) callbacks.GetGamePlayerVelocity = ReplayGetGamePlayerVelocity;
+		if (mask & (1 << REPLAY_VIEWANGLE)) callbacks.GetGamePlayerViewAngle = ReplayGetGamePlayerViewAngle;
+		if (mask & (1 << REPLAY_MOVE_LEFTRIGHT)) callbacks.GetGameMoveLeftRight = ReplayGetGameMoveLeftRight;
+		if (mask & (1 << REPLAY_MOVE_FWDBACK)) callbacks.GetGameMoveFwdBack = ReplayGetGameMoveFwdBack;
+		if (mask & (1 << REPLAY_MOVE_UPDOWN)) callbacks.GetGameMoveUpDown = ReplayGetGameMoveUpDown;
+		if (mask & (1 << REPLAY_MOVE_JUMP)) callbacks.GetGameMoveJump = ReplayGetGameMoveJump;
+		if (mask & (1 << REPLAY_MOVE_DUCK)) callbacks.GetGameMoveDuck = ReplayGetGameMoveDuck;
+		if (mask & (1 << REPLAY_MOVE_RUN)) callbacks.GetGameMoveRun = ReplayGetGameMoveRun;
+		if (mask & (1 << REPLAY_MOVE_USE)) callbacks.GetGameMoveUse = ReplayGetGameMoveUse;
+		if (mask & (1 << REPLAY_POINTCONTENTS)) callbacks.GetPointContents = ReplayGetPointContents;
+		if (mask & (1 << REPLAY_STEPHEIGHT)) callbacks.GetStepHeight = ReplayGetStepHeight;
+		if (mask & (1 << REPLAY_WATERSURFACE)) callbacks.GetWaterSurfaceHeight = ReplayGetWaterSurfaceHeight;
+		if (mask & (1 << REPLAY_ENTITYVELOCITY)) callbacks.GetEntityVelocity = ReplayGetEntityVelocity;
+		if (mask & (1 << REPLAY_POINTRAYTRACE)) callbacks.PointRaytrace = ReplayPointRaytrace;
+		if (mask & (1 << REPLAY_PLAYERTRACE)) callbacks.PM_PlayerTrace = ReplayPM_PlayerTrace;
+		if (mask & (1 << REPLAY_PLAYERTRACEDOWN)) callbacks.PM_PlayerTraceDown = ReplayPM_PlayerTraceDown;
+		callbacks.Restore();
+
+		// the log has every volume the recording had, anything registered right now doesn't belong in it
+		ClearWaterVolumes();
+		ClearLadders();
+
+		FreemanReplayResult result;
+		double start = GetProfileMicros();
+		replayReader.bActive = true;
+		std::vector<uint8_t> blob;
+		while (!replayReader.bDesynced) {
+			int tag = replayReader.PeekTag();
+			if (tag == REPLAY_END) break;
+
+			switch (tag) {
+				case REPLAY_CONFIG:
+					if (!replayReader.ReadBlob(REPLAY_CONFIG, blob) || !DeserializeReplayConfig(blob.data(), blob.size())) {
+						replayReader.bDesynced = true;
+					}
+					break;
+				case REPLAY_WATER:
+					if (!replayReader.ReadBlob(REPLAY_WATER, blob) || !DeserializeWaterVolumes(blob.data(), blob.size())) {
+						replayReader.bDesynced = true;
+					}
+					break;
+				case REPLAY_LADDERS:
+					if (!replayReader.ReadBlob(REPLAY_LADDERS, blob) || !DeserializeLadders(blob.data(), blob.size())) {
+						replayReader.bDesynced = true;
+					}
+					break;
+				case REPLAY_STATE:
+					if (!replayReader.ReadBlob(REPLAY_STATE, blob) || !DeserializePlayerState(blob.data(), blob.size())) {
+						replayReader.bDesynced = true;
+					}
+					break;
+				case REPLAY_RESET: {
+					auto& record = replayReader.Read(REPLAY_RESET);
+					nRandomSeed = record.GetInt(0);
+					nDefaultMoveType = record.GetInt(1);
+					Reset();
+					result.numResets++;
+				} break;
+				case REPLAY_FRAME: {
+					auto& record = replayReader.Read(REPLAY_FRAME);
+					nBudgetQualityLevel = record.GetInt(1);
+					pmove->movetype = record.GetInt(2);
+					Process(record.GetDouble(0));
+					replayReader.numFrames++;
+					result.simulatedSeconds += record.GetDouble(0);
+				} break;
+				default:
+					replayReader.bDesynced = true;
+					break;
+			}
+		}
+		replayReader.bActive = false;
+
+		result.micros = GetProfileMicros() - start;
+		result.numFrames = replayReader.numFrames;
+		result.numOutputMismatches = replayReader.numOutputMismatches;
+		result.firstOutputMismatch = replayReader.firstOutputMismatch;
+		result.desynced = replayReader.bDesynced;
+
+		savedCallbacks.Restore();
+		DeserializeReplayConfig(savedConfig.data(), savedConfig.size());
+		*pmove = savedState;
+		GetContext()->history = savedHistory;
+		GetContext()->view = savedView;
+		aWaterVolumes = std::move(savedWaterVolumes);
+		nWaterRevision++;
+		aLadders = std::move(savedLadders);
+		nLadderRevision++;
+		nRandomSeed = savedRandomSeed;
+		nDefaultMoveType = savedDefaultMoveType;
+		nBudgetQualityLevel = savedQualityLevel;
+		nBudgetCalmFrames = savedCalmFrames;
+
+		if (out) memcpy(out, &result, std::min(out->size, sizeof(result)));
+		return !result.desynced;
+	}
+
+	bool ReplayRecording(const char* path, FreemanReplayResult* out) {
+		if (!path || IsRecordingReplay() || replayReader.IsActive()) return false;
+		if (!replayReader.Open(path)) return false;
+		return RunReplay(out);
+	}
+
+	bool ReplayRecording(const uint8_t* data, size_t size, FreemanReplayResult* out) {
+		if (!data || IsRecordingReplay() || replayReader.IsActive()) return false;
+		if (!replayReader.Open(data, size)) return false;
+		return RunReplay(out);
+	}
+
+	const uint32_t PLAYER_STATE_MAGIC = 0x54535246; // "FRST"
+
+	// a snapshot is the magic, the player as SerializePlayerState writes it, then the frame budget's quality level and calm frames
+	size_t GetStateSize() {
+		return sizeof(PLAYER_STATE_MAGIC) + GetPlayerStateSize() + sizeof(int) * 2;
+	}
+
+	// out needs GetStateSize bytes
+	void SaveState(uint8_t* out) {
+		static FREEMANAPI_THREAD_LOCAL std::vector<uint8_t> data;
+		data.clear();
+		data.insert(data.end(), (const uint8_t*)&PLAYER_STATE_MAGIC, (const uint8_t*)&PLAYER_STATE_MAGIC + sizeof(PLAYER_STATE_MAGIC));
+		SerializePlayerState(data);
+		for (auto value : { nBudgetQualityLevel, nBudgetCalmFrames }) {
+			data.insert(data.end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(value));
+		}
+		memcpy(out, data.data(), data.size());
+	}
+
+	bool LoadState(const uint8_t* data, size_t size) {
+		const size_t budgetSize = sizeof(int) * 2;
+		if (size != GetStateSize()) return false;
+
+		uint32_t magic;
+		memcpy(&magic, data, sizeof(magic));
+		if (magic != PLAYER_STATE_MAGIC) return false;
+
+		auto player = data + sizeof(magic);
+		auto playerSize = size - sizeof(magic) - budgetSize;
+		if (!DeserializePlayerState(player, playerSize)) return false;
+		memcpy(&nBudgetQualityLevel, player + playerSize, sizeof(int));
+		memcpy(&nBudgetCalmFrames, player + playerSize + sizeof(int), sizeof(int));
+		GetContext()->view.bDirty = true;
+		if (IsRecordingReplay()) {
+			std::vector<uint8_t> blob;
+			SerializePlayerState(blob);
+			replayWriter.PutBlob(REPLAY_STATE, blob.data(), blob.size());
+		}
+		return true;
+	}
+
+	// restores a snapshot and re-simulates the given inputs on top of it, for client-side prediction
+	// sounds and fall damage already happened the first time round so they're muted, only the last frame is output to the game
+	// the frame budget is held at the snapshot's quality level, the re-simulated frames' timings aren't the ones the originals ran with
+	bool Rollback(const uint8_t* state, size_t stateSize, const FreemanInputFrame* inputs, int numInputs) {
+		if (!LoadState(state, stateSize)) return false;
+		if (numInputs <= 0) return true;
+
+		tGameCallbacks savedCallbacks;
+		savedCallbacks.Save();
+
+		tGameCallbacks callbacks = savedCallbacks;
+		SetBufferedInputCallbacks(callbacks);
+		callbacks.PlayGameSound = nullptr;
+		callbacks.OnTakeFallDamage = nullptr;
+
+		tGameCallbacks silentCallbacks = callbacks;
+		silentCallbacks.SetGamePlayerPosition = nullptr;
+		silentCallbacks.SetGamePlayerPositionRaw = nullptr;
+		silentCallbacks.SetGamePlayerViewPosition = nullptr;
+		silentCallbacks.SetGamePlayerViewAngle = nullptr;
+
+		bBudgetHeld = true;
+		for (int i = 0; i < numInputs; i++) {
+			pBufferedInput = &inputs[i];
+			if (i == numInputs - 1) callbacks.Restore();
+			else silentCallbacks.Restore();
+			Process(inputs[i].delta);
+		}
+		bBudgetHeld = false;
+		pBufferedInput = nullptr;
+
+		savedCallbacks.Restore();
+		return true;
+	}
 }
\ No newline at end of file
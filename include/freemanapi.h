@@ -1,4 +1,5 @@
 #include "hl_consts.h"
+#include "hl_stats.h"
 
 namespace FreemanAPI {
 	// todo these two structs are currently duplicated!
@@ -109,6 +110,32 @@ namespace FreemanAPI {
 		funcPtr(func);
 	}
 
+	// height of the obstacle blocking a move from origin to dest, above the bottom of the player's box, optional
+	// measured along the game's up axis, so negative if SetUnitInvertXYZ flips that axis
+	// return STEP_HEIGHT_UNKNOWN if you can't tell, anything taller than a step skips the stair stepping traces
+	void Register_GetStepHeight(float(*func)(const double*, const double*)) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(float(*func)(const double*, const double*))>("FreemanAPI_Register_GetStepHeight");
+		if (!funcPtr) return;
+		funcPtr(func);
+	}
+
+	// height of the water surface above the given position, write the contents at the position, optional
+	// write CONTENTS_EMPTY if it's dry, one call then replaces the feet, waist and eye point contents checks
+	void Register_GetWaterSurfaceHeight(double(*func)(const double*, int*)) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(double(*func)(const double*, int*))>("FreemanAPI_Register_GetWaterSurfaceHeight");
+		if (!funcPtr) return;
+		funcPtr(func);
+	}
+
+	// velocity of the entity with this id (as returned in pmtrace_t::ent), lets conveyors, lifts and trains carry the player
+	// fill in the point it spins around, its velocity and its angular velocity in degrees per second in the same order as the view angles
+	// return false if it isn't moving, each entity is only asked about once per frame
+	void Register_GetEntityVelocity(bool(*func)(int ent, double* origin, double* velocity, double* angularVelocity)) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(bool(*func)(int, double*, double*, double*))>("FreemanAPI_Register_GetEntityVelocity");
+		if (!funcPtr) return;
+		funcPtr(func);
+	}
+
 	// point trace check for collisions, used as a fallback if you don't have a suitable AABB trace
 	void Register_PointRaytrace(pmtrace_t*(*func)(const double*, const double*)) {
 		static auto funcPtr = GetFuncPtr<void(__cdecl*)(pmtrace_t*(*func)(const double*, const double*))>("FreemanAPI_Register_PointRaytrace");
@@ -116,6 +143,14 @@ namespace FreemanAPI {
 		funcPtr(func);
 	}
 
+	// several point traces at once, optional, used instead of PointRaytrace wherever the library casts a fan of rays around the player
+	// starts and ends are count xyz triplets, out has room for count traces and comes pre-filled as misses
+	void Register_PointRaytraceBatch(void(*func)(const double*, const double*, int, pmtrace_t*)) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(void(*func)(const double*, const double*, int, pmtrace_t*))>("FreemanAPI_Register_PointRaytraceBatch");
+		if (!funcPtr) return;
+		funcPtr(func);
+	}
+
 	// AABB trace check for collisions, optional
 	void Register_PM_PlayerTrace(pmtrace_t*(*func)(const double*, const double*)) {
 		static auto funcPtr = GetFuncPtr<void(__cdecl*)(pmtrace_t*(*func)(const double*, const double*))>("FreemanAPI_Register_PM_PlayerTrace");
@@ -130,6 +165,15 @@ namespace FreemanAPI {
 		funcPtr(func);
 	}
 
+	// a whole batch of AABB traces at once, optional, only used alongside PM_PlayerTrace
+	// StepContexts with SetLockstepBatching on sends it every player's traces, otherwise a blocked walk move sends its first two traces together
+	// each trace comes with the box and the context it's for, out has room for count traces and comes pre-filled as misses
+	void Register_PM_PlayerTraceBatch(void(*func)(const FreemanHullTrace*, int, pmtrace_t*)) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(void(*func)(const FreemanHullTrace*, int, pmtrace_t*))>("FreemanAPI_Register_PM_PlayerTraceBatch");
+		if (!funcPtr) return;
+		funcPtr(func);
+	}
+
 	// -1 left, 1, right
 	void Register_GetGameMoveLeftRight(float(*func)()) {
 		static auto funcPtr = GetFuncPtr<void(__cdecl*)(float(*func)())>("FreemanAPI_Register_GetGameMoveLeftRight");
@@ -222,6 +266,377 @@ namespace FreemanAPI {
 		funcPtr(delta);
 	}
 
+	// max time FreemanAPI_Process may take in microseconds, 0 to disable
+	// collision quality and physics steps are lowered when a frame would go over, and restored once load drops
+	void SetFrameBudgetMicros(int micros) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(int)>("FreemanAPI_SetFrameBudgetMicros");
+		if (!funcPtr) return;
+		funcPtr(micros);
+	}
+
+	// counters and timings, cumulative unless SetStatsPerFrame is on
+	// every context counts on its own, this and ResetStats are for the current one
+	void GetStats(FreemanStats* out) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(FreemanStats*)>("FreemanAPI_GetStats");
+		if (!funcPtr) return;
+		funcPtr(out);
+	}
+
+	void ResetStats() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ResetStats");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// reset the stats at the start of every FreemanAPI_Process, so they only cover the last frame
+	// the frame budget counters from numFrames to maxFrameMicros are left alone, they keep covering everything since ResetStats
+	void SetStatsPerFrame(bool on) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(bool)>("FreemanAPI_SetStatsPerFrame");
+		if (!funcPtr) return;
+		funcPtr(on);
+	}
+
+	// p50/p90/p99/p99.9/max latency of Process, substeps and the trace callbacks since the last ResetLatencyStats
+	// these are not cleared by ResetStats or SetStatsPerFrame
+	void GetLatencyStats(FreemanLatencyStats* out) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(FreemanLatencyStats*)>("FreemanAPI_GetLatencyStats");
+		if (!funcPtr) return;
+		funcPtr(out);
+	}
+
+	void ResetLatencyStats() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ResetLatencyStats");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// record a timeline of Process, its substeps, movement phases and trace callbacks
+	void SetTimelineEnabled(bool on) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(bool)>("FreemanAPI_SetTimelineEnabled");
+		if (!funcPtr) return;
+		funcPtr(on);
+	}
+
+	// a thread's events are kept until it exits, safe to call while other threads are recording
+	void ClearTimeline() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ClearTimeline");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// write the recorded timeline as chrome trace event json, open it in chrome://tracing or ui.perfetto.dev
+	bool DumpTimeline(const char* path) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const char*)>("FreemanAPI_DumpTimeline");
+		if (!funcPtr) return false;
+		return funcPtr(path);
+	}
+
+	// record every frame's input and host callback results into a binary log for offline replay
+	// callbacks have to be registered before this, a log expects the same set of them throughout
+	bool StartRecording(const char* path) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const char*)>("FreemanAPI_StartRecording");
+		if (!funcPtr) return false;
+		return funcPtr(path);
+	}
+
+	void StopRecording() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_StopRecording");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// re-simulate a log without calling into the game, returns false if it couldn't be loaded or desynced
+	// the current player state, settings and callbacks are left untouched
+	bool ReplayRecording(const char* path, FreemanReplayResult* out) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const char*, FreemanReplayResult*)>("FreemanAPI_ReplayRecording");
+		if (!funcPtr) return false;
+		return funcPtr(path, out);
+	}
+
+	// size of a SaveState snapshot in bytes, fixed for a given build
+	size_t GetStateSize() {
+		static auto funcPtr = GetFuncPtr<size_t(__cdecl*)()>("FreemanAPI_GetStateSize");
+		if (!funcPtr) return 0;
+		return funcPtr();
+	}
+
+	// snapshot the player and the frame budget's quality level, e.g. every tick for client-side prediction
+	// plain memory of GetStateSize bytes, so it can be kept in ring buffers, copied and sent around as-is
+	void SaveState(uint8_t* out) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(uint8_t*)>("FreemanAPI_SaveState");
+		if (!funcPtr) return;
+		funcPtr(out);
+	}
+
+	// returns false if the snapshot is the wrong size or from an incompatible build
+	bool LoadState(const uint8_t* data, size_t size) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const uint8_t*, size_t)>("FreemanAPI_LoadState");
+		if (!funcPtr) return false;
+		return funcPtr(data, size);
+	}
+
+	// load a snapshot and re-simulate buffered inputs on top of it, e.g. from the last acknowledged server state
+	// sounds and fall damage are muted and only the final frame is output to the game
+	// the frame budget's quality level comes from the snapshot and stays there until the re-simulation is done
+	bool Rollback(const uint8_t* state, size_t stateSize, const FreemanInputFrame* inputs, int numInputs) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const uint8_t*, size_t, const FreemanInputFrame*, int)>("FreemanAPI_Rollback");
+		if (!funcPtr) return false;
+		return funcPtr(state, stateSize, inputs, numInputs);
+	}
+
+	// quantization steps for the net state, origin in units, velocity in units per second, angles in bits per full turn
+	// both ends have to use the same settings
+	void SetNetPrecision(double originStep, double velocityStep, int angleBits) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(double, double, int)>("FreemanAPI_SetNetPrecision");
+		if (!funcPtr) return;
+		funcPtr(originStep, velocityStep, angleBits);
+	}
+
+	// quantize the current player for replication
+	void GetNetState(FreemanNetState* out) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(FreemanNetState*)>("FreemanAPI_GetNetState");
+		if (!funcPtr) return;
+		funcPtr(out);
+	}
+
+	// apply a received state to the player, anything not replicated is left alone
+	void SetNetState(const FreemanNetState* in) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(const FreemanNetState*)>("FreemanAPI_SetNetState");
+		if (!funcPtr) return;
+		funcPtr(in);
+	}
+
+	// delta encode a batch of players against baselines the receiver already has, baselines can be null
+	// returns the bytes written or -1 if out is too small
+	int EncodeNetStates(const FreemanNetState* states, const FreemanNetState* baselines, int numPlayers, uint8_t* out, int outSize) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(const FreemanNetState*, const FreemanNetState*, int, uint8_t*, int)>("FreemanAPI_EncodeNetStates");
+		if (!funcPtr) return -1;
+		return funcPtr(states, baselines, numPlayers, out, outSize);
+	}
+
+	// returns the bytes read or -1 if the data was cut short
+	int DecodeNetStates(const uint8_t* in, int inSize, const FreemanNetState* baselines, int numPlayers, FreemanNetState* out) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(const uint8_t*, int, const FreemanNetState*, int, FreemanNetState*)>("FreemanAPI_DecodeNetStates");
+		if (!funcPtr) return -1;
+		return funcPtr(in, inSize, baselines, numPlayers, out);
+	}
+
+	// creates another simulated player, returns its id, switch to it with SetContext and call ResetPhysics before use
+	// settings and callbacks are shared between all contexts, the stats and the frame budget's quality level are per context
+	int CreateContext() {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)()>("FreemanAPI_CreateContext");
+		if (!funcPtr) return -1;
+		return funcPtr();
+	}
+
+	// context 0 can't be destroyed
+	void DestroyContext(int id) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(int)>("FreemanAPI_DestroyContext");
+		if (!funcPtr) return;
+		funcPtr(id);
+	}
+
+	// everything else in the api acts on the current context
+	bool SetContext(int id) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(int)>("FreemanAPI_SetContext");
+		if (!funcPtr) return false;
+		return funcPtr(id);
+	}
+
+	int GetContext() {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)()>("FreemanAPI_GetContext");
+		if (!funcPtr) return 0;
+		return funcPtr();
+	}
+
+	// one Process of every listed context, with SetLockstepBatching on their hull traces are gathered up and sent to PM_PlayerTraceBatch together
+	// the callbacks get called for the players in turn, GetContext inside them says whose frame it is
+	// comes out the same as calling Process on each of them, the frame budget is held while doing it and every quality level stays put
+	// returns the number of batched trace calls it took, 0 if the contexts just went one after the other, -1 for bad ids or while recording or replaying
+	int StepContexts(const int* ids, int numIds, double delta) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(const int*, int, double)>("FreemanAPI_StepContexts");
+		if (!funcPtr) return -1;
+		return funcPtr(ids, numIds, delta);
+	}
+
+	// off by default, only turn this on if PM_PlayerTraceBatch hands the traces to a collider that runs them in parallel or off the thread
+	// every context in a step gets a fiber with a 256 KB stack and every hull trace switches fibers twice
+	// with a collider that just runs the traces one by one in process that's about 3x slower than leaving it off
+	void SetLockstepBatching(bool on) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(bool)>("FreemanAPI_SetLockstepBatching");
+		if (!funcPtr) return;
+		funcPtr(on);
+	}
+
+	// the clock the hull history is stamped with, advanced by every substep
+	// set it to the server time before processing to query the history in server time
+	void SetSimTime(double time) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(double)>("FreemanAPI_SetSimTime");
+		if (!funcPtr) return;
+		funcPtr(time);
+	}
+
+	double GetSimTime() {
+		static auto funcPtr = GetFuncPtr<double(__cdecl*)()>("FreemanAPI_GetSimTime");
+		if (!funcPtr) return 0;
+		return funcPtr();
+	}
+
+	// yaw the player has been turned by rotating platforms, added on top of GetGamePlayerViewAngle's yaw
+	// hosts that turn their own camera instead can add this to it and set it back to 0
+	void SetCarriedYaw(double yaw) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(double)>("FreemanAPI_SetCarriedYaw");
+		if (!funcPtr) return;
+		funcPtr(yaw);
+	}
+
+	double GetCarriedYaw() {
+		static auto funcPtr = GetFuncPtr<double(__cdecl*)()>("FreemanAPI_GetCarriedYaw");
+		if (!funcPtr) return 0;
+		return funcPtr();
+	}
+
+	// hull history samples kept per context, one per substep, 0 turns it off. defaults to 256
+	void SetHullHistoryLength(int length) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(int)>("FreemanAPI_SetHullHistoryLength");
+		if (!funcPtr) return;
+		funcPtr(length);
+	}
+
+	// where the current context's hull was at a past time, for lag compensation
+	bool GetHullAtTime(double time, FreemanHullSample* out) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(double, FreemanHullSample*)>("FreemanAPI_GetHullAtTime");
+		if (!funcPtr) return false;
+		return funcPtr(time, out);
+	}
+
+	// rewinds every context at once, out is indexed by context id, returns the number of context ids
+	int RewindAllContexts(double time, FreemanHullSample* out, int maxContexts) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(double, FreemanHullSample*, int)>("FreemanAPI_RewindAllContexts");
+		if (!funcPtr) return 0;
+		return funcPtr(time, out, maxContexts);
+	}
+
+	// everything the current context's player ran into during the last frame, one entry per entity and plane
+	// copies up to maxTouches, returns how many there were, out can be null to just get the count
+	int GetTouches(FreemanTouch* out, int maxTouches) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(FreemanTouch*, int)>("FreemanAPI_GetTouches");
+		if (!funcPtr) return 0;
+		return funcPtr(out, maxTouches);
+	}
+
+	// eye position and angles of the current context's player with bob, roll and punch, in the same space as the view callbacks
+	// worked out on the first call after a Process, either can be null
+	void GetView(double* origin, double* angles) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(double*, double*)>("FreemanAPI_GetView");
+		if (!funcPtr) return;
+		funcPtr(origin, angles);
+	}
+
+	// queues an input change for the current context's next Process, each substep takes the events before its end
+	// once a type has been queued it's no longer polled from the callbacks, until ClearInputEvents
+	// returns false if the type is invalid or the queue is full
+	bool QueueInputEvent(const FreemanInputEvent* event) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const FreemanInputEvent*)>("FreemanAPI_QueueInputEvent");
+		if (!funcPtr) return false;
+		return funcPtr(event);
+	}
+
+	// drops the queued events and goes back to polling the input callbacks once per frame
+	void ClearInputEvents() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ClearInputEvents");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// runs the physics on a library owned thread at a fixed tick rate instead of in Process
+	// only use this if the trace, point contents and player dead callbacks are safe to call from another thread
+	// while it's running everything that touches the player, the contexts, the callbacks, the world or the settings the physics reads
+	// does nothing and returns false, -1 or nullptr, that includes the config pointers and the debug menu
+	// call StopSimThread before unloading the library
+	bool StartSimThread(double tickRate, bool callbacksThreadSafe) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(double, bool)>("FreemanAPI_StartSimThread");
+		if (!funcPtr) return false;
+		return funcPtr(tickRate, callbacksThreadSafe);
+	}
+
+	void StopSimThread() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_StopSimThread");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// queues input for the next sim thread tick, delta is ignored, returns false if the queue is full
+	bool PushSimInput(const FreemanInputFrame* input) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(const FreemanInputFrame*)>("FreemanAPI_PushSimInput");
+		if (!funcPtr) return false;
+		return funcPtr(input);
+	}
+
+	// call once per game frame, plays queued sounds and sets the interpolated player through the output callbacks
+	bool PollSimThread(FreemanSimFrame* out) {
+		static auto funcPtr = GetFuncPtr<bool(__cdecl*)(FreemanSimFrame*)>("FreemanAPI_PollSimThread");
+		if (!funcPtr) return false;
+		return funcPtr(out);
+	}
+
+	// water volumes the library checks on its own, in game space like everything else
+	// points inside them never reach the point contents callback, points outside still do if one is registered
+	// contents is CONTENTS_WATER, CONTENTS_SLIME or CONTENTS_LAVA, returns the volume id or -1
+	// these do nothing while the sim thread is running
+	int AddWaterBox(const double* mins, const double* maxs, int contents) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(const double*, const double*, int)>("FreemanAPI_AddWaterBox");
+		if (!funcPtr) return -1;
+		return funcPtr(mins, maxs, contents);
+	}
+
+	// convex volume, planes are 4 doubles each (normal, distance) with the inside where dot(normal, point) <= distance
+	int AddWaterHull(const double* planes, int numPlanes, const double* mins, const double* maxs, int contents) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(const double*, int, const double*, const double*, int)>("FreemanAPI_AddWaterHull");
+		if (!funcPtr) return -1;
+		return funcPtr(planes, numPlanes, mins, maxs, contents);
+	}
+
+	// everything below the height, for a sea covering the whole map
+	int AddWaterPlane(double height, int contents) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(double, int)>("FreemanAPI_AddWaterPlane");
+		if (!funcPtr) return -1;
+		return funcPtr(height, contents);
+	}
+
+	void RemoveWaterVolume(int id) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(int)>("FreemanAPI_RemoveWaterVolume");
+		if (!funcPtr) return;
+		funcPtr(id);
+	}
+
+	void ClearWaterVolumes() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ClearWaterVolumes");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
+	// climbable box in game space, normal points out of the ladder towards where the player climbs from
+	// depth runs along the normal, width across it and height straight up, the player's box has to overlap it to grab on
+	// returns the ladder id or -1, these do nothing while the sim thread is running
+	int AddLadder(const double* center, const double* normal, double width, double height, double depth) {
+		static auto funcPtr = GetFuncPtr<int(__cdecl*)(const double*, const double*, double, double, double)>("FreemanAPI_AddLadder");
+		if (!funcPtr) return -1;
+		return funcPtr(center, normal, width, height, depth);
+	}
+
+	void RemoveLadder(int id) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(int)>("FreemanAPI_RemoveLadder");
+		if (!funcPtr) return;
+		funcPtr(id);
+	}
+
+	void ClearLadders() {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ClearLadders");
+		if (!funcPtr) return;
+		funcPtr();
+	}
+
 	void ProcessChloeMenu() {
 		static auto funcPtr = GetFuncPtr<void(__cdecl*)()>("FreemanAPI_ProcessChloeMenu");
 		if (!funcPtr) return;
@@ -252,6 +667,13 @@ namespace FreemanAPI {
 		funcPtr(type);
 	}
 
+	// seed for footstep and pain sound variations, also reapplied on every ResetPhysics
+	void SetRandomSeed(uint64_t seed) {
+		static auto funcPtr = GetFuncPtr<void(__cdecl*)(uint64_t)>("FreemanAPI_SetRandomSeed");
+		if (!funcPtr) return;
+		funcPtr(seed);
+	}
+
 	bool GetIsEnabled() {
 		static auto funcPtr = GetFuncPtr<bool(__cdecl*)()>("FreemanAPI_GetIsEnabled");
 		if (!funcPtr) return false;
@@ -338,6 +760,7 @@ namespace FreemanAPI {
 		return funcPtr();
 	}
 
+	// pointers straight into the settings the physics reads, nullptr while the sim thread is running
 	bool* GetConfigBoolean(const char* label) {
 		static auto funcPtr = GetFuncPtr<bool*(__cdecl*)(const char*)>("FreemanAPI_GetConfigBoolean");
 		if (!funcPtr) return nullptr;
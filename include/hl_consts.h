@@ -145,4 +145,17 @@ namespace FreemanAPI {
 		SPEED_CROPPED_DUCK = 1,
 		SPEED_CROPPED_WEAPON = 2,
 	};
+
+	// FreemanInputEvent types, one per FreemanInputFrame field
+	enum {
+		INPUT_EVENT_FWDBACK,
+		INPUT_EVENT_LEFTRIGHT,
+		INPUT_EVENT_UPDOWN,
+		INPUT_EVENT_JUMP,
+		INPUT_EVENT_DUCK,
+		INPUT_EVENT_RUN,
+		INPUT_EVENT_USE,
+		INPUT_EVENT_VIEWANGLES,
+		NUM_INPUT_EVENTS,
+	};
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+// FreemanAPI runtime stats, shared between the library and the client header
+namespace FreemanAPI {
+	struct FreemanStats {
+		size_t size;
+
+		// frame budget, see SetFrameBudgetMicros
+		// these keep counting with SetStatsPerFrame on, only ResetStats clears them
+		uint32_t numFrames;
+		uint32_t numBudgetOverruns;		// frames that took longer than the budget
+		uint32_t numBudgetDegrades;		// times the collision quality was stepped down
+		uint32_t numBudgetRestores;		// times the collision quality was stepped back up
+		int budgetQualityLevel;			// 0 = full quality, higher = more degraded
+		float lastFrameMicros;
+		float maxFrameMicros;
+
+		// movement, times are inclusive of any nested calls
+		uint32_t numSubsteps;
+		uint32_t numBumpIterations;		// PM_FlyMove clip loop iterations
+		uint32_t numClipPlaneOverflows;	// ran out of clip planes in PM_FlyMove
+		double microsCatagorizePosition;
+		double microsFlyMove;
+		double microsWalkMove;
+		double microsDuckHL1;			// PM_Duck
+		double microsDuckHL2;			// Duck
+
+		// host callback invocations
+		uint32_t numPlayerTraceCalls;
+		uint32_t numPlayerTraceDownCalls;
+		uint32_t numPointRaytraceCalls;
+		uint32_t numPointContentsCalls;
+		uint32_t numInputPollCalls;		// GetGameMove*
+		uint32_t numPlayerStateCalls;	// GetGamePlayer*
+		uint32_t numPlayerOutputCalls;	// SetGamePlayer*
+		uint32_t numSoundCalls;
+		uint32_t numFallDamageCalls;
+
+		// movement outcomes, these are the events also reported in the debug menu
+		uint32_t numUnduckStuck;		// "unstick got stuck"
+		uint32_t numVelocityClamps;		// "PM Got a velocity too high/low"
+		uint32_t numTrapped;			// "Trapped 4"
+		uint32_t numBlockedByWall;		// "Blocked by"
+		uint32_t numCreaseStops;		// "clip velocity, numplanes == "
+		uint32_t numBackStops;			// "Back"
+		uint32_t numDontStick;			// "Don't stick"
+		uint32_t numSmallSpeedClears;	// "clearing small speed"
+
+		// appended, older clients only get the fields above
+		uint32_t numPointRaytraceBatchCalls;	// the rays in a batch aren't counted in numPointRaytraceCalls
+		uint32_t numStepHeightCalls;
+		uint32_t numStepUpSkips;		// PM_WalkMove stair paths skipped because the obstacle was too tall
+		uint32_t numPlayerTraceBatchCalls;	// PM_WalkMove's direct and step up traces sent together, not counted in numPlayerTraceCalls
+		uint32_t numCollisionRays;		// rays cast by the point raytrace fallback probes
+		float avgCollisionRaysPerFrame;
+		uint32_t numWaterVolumeHits;	// water checks answered by a registered volume instead of the point contents callback
+		uint32_t numWaterSurfaceCalls;
+		uint32_t numTouches;
+		uint32_t numTouchesDropped;		// touch buffer was full
+		uint32_t numEntityVelocityCalls;
+		uint32_t numStuckChecks;		// PM_CheckStuck runs, only after a solid trace
+		uint32_t numStuckTests;			// positions tested by PM_CheckStuck
+		uint32_t numStuck;				// "stuck", nowhere to nudge the player to
+		uint32_t numInputEvents;		// queued input events applied
+		uint32_t numViewCalcs;			// CalcView runs, at most one per frame
+
+		FreemanStats() {
+			Default();
+		}
+
+		void Default() {
+			memset(this, 0, sizeof(*this));
+			size = sizeof(*this);
+		}
+	};
+
+	// latency percentiles in microseconds, see GetLatencyStats
+	// count is the number of timed calls, the trace callbacks only time every 8th one and report max as 0
+	struct FreemanLatency {
+		uint32_t count;
+		float p50;
+		float p90;
+		float p99;
+		float p999;
+		float max;
+	};
+
+	struct FreemanLatencyStats {
+		size_t size;
+
+		FreemanLatency process;			// whole FreemanAPI_Process call
+		FreemanLatency substep;			// a single physics step
+		FreemanLatency playerTrace;		// per EXT_PM_PlayerTrace call
+		FreemanLatency pointRaytrace;	// per EXT_PointRaytrace call
+		FreemanLatency pointContents;	// per EXT_GetPointContents call
+
+		FreemanLatencyStats() {
+			memset(this, 0, sizeof(*this));
+			size = sizeof(*this);
+		}
+	};
+
+	// result of ReplayRecording
+	struct FreemanReplayResult {
+		size_t size;
+
+		uint32_t numFrames;
+		uint32_t numResets;
+		uint32_t numOutputMismatches;	// frames where position, velocity or view angles didn't come out bit-identical to the recording
+		int firstOutputMismatch;		// frame index of the first mismatch, -1 if none
+		bool desynced;					// the simulation asked the host for something the log doesn't have, the replay stopped there
+		double micros;					// wall time the replay took
+		double simulatedSeconds;		// sum of the recorded frame deltas
+
+		FreemanReplayResult() {
+			memset(this, 0, sizeof(*this));
+			size = sizeof(*this);
+		}
+	};
+
+	// one frame of buffered input for Rollback, replaces the GetGameMove* and view angle callbacks
+	struct FreemanInputFrame {
+		double delta;
+		double viewAngles[3];
+		float fwdBack;
+		float leftRight;
+		float upDown;
+		bool jump;
+		bool duck;
+		bool run;
+		bool use;
+	};
+
+	// one change to the input somewhere inside the next Process call, see QueueInputEvent
+	struct FreemanInputEvent {
+		double time;					// seconds after the start of the next Process call, ones past its end wait for the frame after
+		int type;						// INPUT_EVENT_*
+		double value[3];				// the axis, 0 or 1 for buttons, view angles use all three
+	};
+
+	// quantized player state for replication, see GetNetState and EncodeNetStates
+	struct FreemanNetState {
+		int32_t values[16];
+	};
+
+	// where a player's hull was at some point in the past, in the same space as the game callbacks
+	struct FreemanHullSample {
+		double time;
+		double origin[3];				// hull center
+		double mins[3];					// relative to the center
+		double maxs[3];
+		int hull;						// 0 = standing, 1 = ducked, 2 = point
+		bool ducked;
+		bool valid;						// false if the history doesn't go back that far
+	};
+
+	// one of the hull traces StepContexts hands to PM_PlayerTraceBatch, in the same space as PM_PlayerTrace
+	struct FreemanHullTrace {
+		double start[3];
+		double end[3];
+		double mins[3];					// the context's player box, same as GetPlayerBBoxMin and GetPlayerBBoxMax would return
+		double maxs[3];
+		int context;					// whose trace it is
+	};
+
+	// what a GetStepHeight callback returns when it can't tell, compared before any unit or axis conversion
+	const float STEP_HEIGHT_UNKNOWN = -3.402823466e+38f;
+
+	// something the player ran into during a frame, in the same space as the game callbacks
+	struct FreemanTouch {
+		int ent;						// from the trace that hit it
+		int surfaceId;
+		double normal[3];				// plane normal of what was hit
+		double velocity[3];				// player velocity going into the hit
+	};
+
+	// one tick of the simulation thread, in the same space as the SetGamePlayer callbacks
+	struct FreemanSimFrame {
+		double time;					// simulated seconds since the thread was started
+		double origin[3];				// SetGamePlayerPosition
+		double originRaw[3];			// SetGamePlayerPositionRaw
+		double velocity[3];
+		double viewOrigin[3];			// SetGamePlayerViewPosition
+		double viewAngles[3];			// SetGamePlayerViewAngle
+		uint32_t tick;
+	};
+}
\ No newline at end of file
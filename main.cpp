@@ -4,6 +4,8 @@
 #include <string>
 #include <format>
 #include <filesystem>
+#include <atomic>
+#include <thread>
 #include "toml++/toml.hpp"
 
 #include "nya_commonmath.h"
@@ -13,12 +15,17 @@
 #endif
 
 #include "hlmov.h"
+#include "hl_simthread.h"
+#include "hl_lockstep.h"
 #include "hl_exports.h"
 
 BOOL WINAPI DllMain(HINSTANCE, DWORD fdwReason, LPVOID) {
 	switch( fdwReason ) {
 		case DLL_PROCESS_ATTACH: {
 
+		} break;
+		case DLL_PROCESS_DETACH: {
+			FreemanAPI::DetachSimThread();
 		} break;
 		default:
 			break;
@@ -0,0 +1,736 @@
+// headless movement benchmark
+// runs scripted input through the movement code against synthetic worlds, no game or dll needed
+// usage: FreemanAPI_bench [frames] [world] [script]
+//        FreemanAPI_bench --golden|--update-golden [dir], dir defaults to tools/golden
+//        FreemanAPI_bench --rollback [ticks] [budget us]
+//        FreemanAPI_bench --fallback
+//        FreemanAPI_bench --netstate
+//        FreemanAPI_bench --inputevents
+//        FreemanAPI_bench --latency [threads]
+//        FreemanAPI_bench --lockstep [players] [callback us]
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <format>
+#include <filesystem>
+#include <atomic>
+#include <thread>
+#include <new>
+#include "toml++/toml.hpp"
+
+#include "nya_commonmath.h"
+
+#include "hlmov.h"
+#include "hl_lockstep.h"
+#include "bench_world.h"
+
+// count every heap allocation the movement code makes
+// the array forms are replaced along with the others so every new is paired with the matching delete
+// and the deletes are kept out of line, gcc inlining free() into library code next to a builtin operator new warns about a mismatch
+std::atomic<uint64_t> nNumAllocs = 0;
+
+void* operator new(size_t size) {
+	nNumAllocs.fetch_add(1, std::memory_order_relaxed);
+	if (auto ptr = malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+[[gnu::noinline]] void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+[[gnu::noinline]] void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+namespace FreemanBench {
+	const double FRAME_TIME = 1.0 / 60.0;
+
+	int nFrame = 0;
+
+	// scripted input, everything is a function of the frame number so every run is identical
+	struct tScript {
+		const char* name;
+		float(*fwdBack)();
+		float(*leftRight)();
+		float(*upDown)();
+		bool(*jump)();
+		bool(*duck)();
+		bool(*run)();
+		void(*viewAngle)(double*);
+	};
+
+	const tScript aScripts[] = {
+		{
+			"run",
+			[]() { return 1.0f; },
+			[]() { return 0.0f; },
+			[]() { return 0.0f; },
+			[]() { return false; },
+			[]() { return false; },
+			[]() { return true; },
+			[](double* out) { out[YAW] = std::sin(nFrame * 0.01) * 20; out[PITCH] = 0; out[ROLL] = 0; },
+		},
+		{
+			"climb",
+			[]() { return 1.0f; },
+			[]() { return 0.0f; },
+			[]() { return 0.0f; },
+			[]() { return false; },
+			[]() { return false; },
+			[]() { return false; },
+			// straight at the stairs, which run along +x
+			[](double* out) { out[YAW] = std::sin(nFrame * 0.01) * 20; out[PITCH] = 0; out[ROLL] = 0; },
+		},
+		{
+			"strafejump",
+			[]() { return nFrame < 60 ? 1.0f : 0.0f; },
+			[]() { return nFrame < 60 ? 0.0f : (nFrame / 20) % 2 ? -1.0f : 1.0f; },
+			[]() { return 0.0f; },
+			[]() { return true; },
+			[]() { return false; },
+			[]() { return false; },
+			// air strafing, turning into the strafe like a player would
+			[](double* out) { out[YAW] = ((nFrame / 20) % 2 ? 1 : -1) * ((nFrame % 20) - 10) * 3.0; out[PITCH] = 0; out[ROLL] = 0; },
+		},
+		{
+			"duckjump",
+			[]() { return 1.0f; },
+			[]() { return 0.0f; },
+			[]() { return 0.0f; },
+			[]() { return nFrame % 60 < 2; },
+			[]() { return nFrame % 60 >= 2 && nFrame % 60 < 40; },
+			[]() { return false; },
+			[](double* out) { out[YAW] = 0; out[PITCH] = 0; out[ROLL] = 0; },
+		},
+		{
+			"jump",
+			[]() { return 0.0f; },
+			[]() { return 0.0f; },
+			[]() { return 0.0f; },
+			[]() { return nFrame % 60 < 2; },
+			[]() { return false; },
+			[]() { return false; },
+			[](double* out) { out[YAW] = 0; out[PITCH] = 0; out[ROLL] = 0; },
+		},
+		{
+			"backhop",
+			[]() { return -1.0f; },
+			[]() { return 0.0f; },
+			[]() { return 0.0f; },
+			[]() { return true; },
+			[]() { return false; },
+			[]() { return false; },
+			[](double* out) { out[YAW] = 0; out[PITCH] = 0; out[ROLL] = 0; },
+		},
+		{
+			"swim",
+			[]() { return 1.0f; },
+			[]() { return 0.0f; },
+			[]() { return (nFrame / 60) % 2 ? 1.0f : 0.0f; },
+			[]() { return (nFrame / 60) % 2 == 1; },
+			[]() { return false; },
+			[]() { return false; },
+			[](double* out) { out[YAW] = nFrame * 0.5; out[PITCH] = (nFrame / 90) % 2 ? -30 : 30; out[ROLL] = 0; },
+		},
+	};
+
+	const tScript* FindScript(const char* name) {
+		for (auto& script : aScripts) {
+			if (!strcmp(script.name, name)) return &script;
+		}
+		return nullptr;
+	}
+
+	tWorld* FindWorld(std::vector<tWorld>& worlds, const char* name) {
+		for (auto& world : worlds) {
+			if (!strcmp(world.name, name)) return &world;
+		}
+		return nullptr;
+	}
+
+	const tWorld* pSpawnWorld = nullptr;
+
+	void GetSpawnPosition(double* out) {
+		out[0] = pSpawnWorld->spawn.x;
+		out[1] = pSpawnWorld->spawn.y;
+		out[2] = pSpawnWorld->spawn.z;
+	}
+
+	void GetSpawnVelocity(double* out) {
+		out[0] = out[1] = out[2] = 0;
+	}
+
+	void SetupHeadless() {
+		// same as FreemanAPI_SetIsZUp(true) and FreemanAPI_SetConvertUnits(false)
+		NyaMat4x4::bZUp = true;
+		FORWARD = 1;
+		UP = 2;
+		bConvertUnits = false;
+		FillConfig();
+	}
+
+	void SetupRun(tWorld& world, const tScript& script, bool hl2, bool fallback) {
+		pWorld = &world;
+		pSpawnWorld = &world;
+		bHL2Mode = hl2;
+
+		EXT_GetGamePlayerPosition = GetSpawnPosition;
+		EXT_GetGamePlayerVelocity = GetSpawnVelocity;
+		EXT_GetGamePlayerViewAngle = script.viewAngle;
+		EXT_GetGameMoveFwdBack = script.fwdBack;
+		EXT_GetGameMoveLeftRight = script.leftRight;
+		EXT_GetGameMoveUpDown = script.upDown;
+		EXT_GetGameMoveJump = script.jump;
+		EXT_GetGameMoveDuck = script.duck;
+		EXT_GetGameMoveRun = script.run;
+		EXT_GetPointContents = WorldPointContents;
+		EXT_PointRaytrace = WorldPointRaytrace;
+		EXT_PM_PlayerTrace = fallback ? nullptr : WorldPlayerTrace;
+		EXT_PM_PlayerTraceDown = nullptr;
+		EXT_PointRaytraceBatch = nullptr;
+		EXT_PM_PlayerTraceBatch = nullptr;
+		EXT_GetStepHeight = nullptr;
+		EXT_GetWaterSurfaceHeight = nullptr;
+
+		nFrame = 0;
+		Reset();
+	}
+
+	struct tRunResult {
+		double nsPerSubstep;
+		float p50, p99;
+		double callbacksPerFrame;
+		double allocsPerFrame;
+		NyaVec3Double endPos;
+	};
+
+	enum {
+		COLLISION_HULL,
+		COLLISION_HULL_STEP_PROBE,
+		COLLISION_HULL_BATCH,
+		COLLISION_POINTRAY,
+		COLLISION_POINTRAY_BATCH,
+		NUM_COLLISION_MODES
+	};
+	const char* aCollisionModeNames[] = { "hull", "stepprobe", "hullbatch", "pointray", "batch" };
+
+	tRunResult RunBenchmark(tWorld& world, const tScript& script, bool hl2, int collision, int numFrames) {
+		SetupRun(world, script, hl2, collision == COLLISION_POINTRAY || collision == COLLISION_POINTRAY_BATCH);
+		EXT_PointRaytraceBatch = collision == COLLISION_POINTRAY_BATCH ? WorldPointRaytraceBatch : nullptr;
+		EXT_PM_PlayerTraceBatch = collision == COLLISION_HULL_BATCH ? WorldPlayerTraceBatch : nullptr;
+		EXT_GetStepHeight = collision == COLLISION_HULL_STEP_PROBE ? WorldStepHeight : nullptr;
+		EXT_GetWaterSurfaceHeight = collision == COLLISION_HULL_STEP_PROBE ? WorldWaterSurfaceHeight : nullptr;
+		ResetStats();
+		ResetLatencyStats();
+
+		uint64_t allocsBefore = nNumAllocs;
+		double start = GetProfileMicros();
+		for (nFrame = 0; nFrame < numFrames; nFrame++) {
+			Process(FRAME_TIME);
+		}
+		double micros = GetProfileMicros() - start;
+
+		FreemanLatencyStats latency;
+		GetLatencyStats(&latency);
+
+		tRunResult result;
+		result.nsPerSubstep = micros * 1000.0 / std::max(stats.numSubsteps, 1u);
+		result.p50 = latency.substep.p50 * 1000;
+		result.p99 = latency.substep.p99 * 1000;
+		auto numCallbacks = stats.numPlayerTraceCalls + stats.numPlayerTraceDownCalls + stats.numPointRaytraceCalls + stats.numPointRaytraceBatchCalls + stats.numPointContentsCalls + stats.numStepHeightCalls + stats.numPlayerTraceBatchCalls + stats.numWaterSurfaceCalls;
+		result.callbacksPerFrame = numCallbacks / (double)numFrames;
+		result.allocsPerFrame = (nNumAllocs - allocsBefore) / (double)numFrames;
+		result.endPos = pmove->origin;
+		return result;
+	}
+
+	FreemanInputFrame GetScriptInput(const tScript& script) {
+		FreemanInputFrame input;
+		input.delta = FRAME_TIME;
+		script.viewAngle(input.viewAngles);
+		input.fwdBack = script.fwdBack();
+		input.leftRight = script.leftRight();
+		input.upDown = script.upDown();
+		input.jump = script.jump();
+		input.duck = script.duck();
+		input.run = script.run();
+		input.use = false;
+		return input;
+	}
+
+	// plays a script while keeping a snapshot and the input of every frame, then rolls back over and over
+	// re-simulating numTicks frames each time, like a client getting a late server ack every frame
+	// with a budget too small to ever meet the quality bottoms out on the first frame, then the budget is lifted before rolling back
+	// so the rollbacks only match if the snapshots bring their quality level with them
+	void RunRollbackBenchmark(tWorld& world, const tScript& script, bool hl2, int numFrames, int numTicks, int budgetMicros) {
+		SetupRun(world, script, hl2, false);
+		nFrameBudgetMicros = budgetMicros;
+		nBudgetQualityLevel = 0;
+		nBudgetCalmFrames = 0;
+		if (budgetMicros) Process(FRAME_TIME);
+
+		auto stateSize = GetStateSize();
+		std::vector<uint8_t> states(numFrames * stateSize);
+		std::vector<FreemanInputFrame> inputs(numFrames);
+		std::vector<NyaVec3Double> origins(numFrames);
+		for (nFrame = 0; nFrame < numFrames; nFrame++) {
+			SaveState(&states[nFrame * stateSize]);
+			inputs[nFrame] = GetScriptInput(script);
+			Process(FRAME_TIME);
+			origins[nFrame] = pmove->origin;
+		}
+
+		nFrameBudgetMicros = 0;
+		nBudgetQualityLevel = 0;
+
+		int numRollbacks = 0;
+		int numMismatches = 0;
+		double start = GetProfileMicros();
+		for (int i = numTicks; i < numFrames; i++) {
+			Rollback(&states[(i - numTicks) * stateSize], stateSize, &inputs[i - numTicks], numTicks);
+			if (memcmp(&pmove->origin, &origins[i - 1], sizeof(pmove->origin))) numMismatches++;
+			numRollbacks++;
+		}
+		double micros = GetProfileMicros() - start;
+		nBudgetQualityLevel = 0;
+
+		printf("%-4s %-9s %-11s %12.2f %12d\n", hl2 ? "hl2" : "hl1", world.name, script.name, micros / std::max(numRollbacks, 1), numMismatches);
+	}
+
+	// plays a script on the point raytrace fallback and counts the frames that end with the player's hull inside something
+	// the hull trace it's checked with is the bench world's own, the movement code never gets to see it
+	int RunFallbackCheck(tWorld& world, const tScript& script, bool hl2, int numFrames) {
+		SetupRun(world, script, hl2, true);
+		ResetStats();
+
+		int numEmbedded = 0;
+		for (nFrame = 0; nFrame < numFrames; nFrame++) {
+			Process(FRAME_TIME);
+			if (WorldPlayerTrace(&pmove->origin.x, &pmove->origin.x)->startsolid) numEmbedded++;
+		}
+		printf("%-4s %-9s %-11s %12u %12d\n", hl2 ? "hl2" : "hl1", world.name, script.name, stats.numCollisionRays / numFrames, numEmbedded);
+		return numEmbedded;
+	}
+
+	// records every scripted run as one player, then replicates all of them at once every tick
+	void RunNetStateBenchmark(std::vector<tWorld>& worlds, int numFrames) {
+		int numPlayers = 2 * worlds.size() * std::size(aScripts);
+		std::vector<FreemanNetState> states(numFrames * numPlayers); // [frame][player]
+		double maxOriginError = 0;
+		double maxVelocityError = 0;
+
+		int player = 0;
+		for (int hl2 = 0; hl2 < 2; hl2++) {
+			for (auto& world : worlds) {
+				for (auto& script : aScripts) {
+					SetupRun(world, script, hl2, false);
+					for (nFrame = 0; nFrame < numFrames; nFrame++) {
+						Process(FRAME_TIME);
+
+						auto& state = states[nFrame * numPlayers + player];
+						GetNetState(&state);
+
+						// round trip into the context to check the precision
+						auto saved = *pmove;
+						SetNetState(&state);
+						maxOriginError = std::max(maxOriginError, (pmove->origin - saved.origin).length());
+						maxVelocityError = std::max(maxVelocityError, (pmove->velocity - saved.velocity).length());
+						*pmove = saved;
+					}
+					player++;
+				}
+			}
+		}
+
+		std::vector<uint8_t> buffer(numPlayers * sizeof(FreemanNetState) * 2);
+		std::vector<FreemanNetState> decoded(numPlayers);
+		for (int delta = 0; delta < 2; delta++) {
+			uint64_t numBytes = 0;
+			int numMismatches = 0;
+			double encodeMicros = 0;
+			double decodeMicros = 0;
+			for (int frame = 1; frame < numFrames; frame++) {
+				auto current = &states[frame * numPlayers];
+				auto baseline = delta ? &states[(frame - 1) * numPlayers] : nullptr;
+
+				double start = GetProfileMicros();
+				int size = EncodeNetStates(current, baseline, numPlayers, buffer.data(), buffer.size());
+				double mid = GetProfileMicros();
+				int read = DecodeNetStates(buffer.data(), size, baseline, numPlayers, decoded.data());
+				double end = GetProfileMicros();
+
+				encodeMicros += mid - start;
+				decodeMicros += end - mid;
+				numBytes += size;
+				if (read != size || memcmp(decoded.data(), current, numPlayers * sizeof(FreemanNetState))) numMismatches++;
+			}
+
+			double numSamples = (numFrames - 1) * (double)numPlayers;
+			printf("%-9s %10.2f %10.1f %10.1f %12d\n", delta ? "delta" : "full", numBytes / numSamples, encodeMicros * 1000 / numSamples, decodeMicros * 1000 / numSamples, numMismatches);
+		}
+		printf("\n%d players, raw state %d bytes, max round trip error %.4f units, %.4f units/s\n", numPlayers, (int)sizeof(FreemanNetState), maxOriginError, maxVelocityError);
+	}
+
+	void QueueInput(double time, int type, double value) {
+		FreemanInputEvent event = {};
+		event.time = time;
+		event.type = type;
+		event.value[0] = value;
+		QueueInputEvent(event);
+	}
+
+	int nNumJumpPolls = 0;
+	bool NoJump() { nNumJumpPolls++; return false; }
+	bool NotDead() { return false; }
+
+	// a standing player on the ground with the jump callback never pressed, so only queued jumps can lift it
+	void SetupInputEventRun(tWorld& world) {
+		SetupRun(world, *FindScript("jump"), false, false);
+		EXT_GetGameMoveJump = NoJump;
+		ClearInputEvents();
+		for (nFrame = 0; nFrame < 60; nFrame++) {
+			Process(FRAME_TIME);
+		}
+		nNumJumpPolls = 0;
+	}
+
+	bool CheckInputEvents(const char* name, bool ok) {
+		printf("%-44s %s\n", name, ok ? "ok" : "FAILED");
+		return ok;
+	}
+
+	// self-checking, returns the number of cases that failed
+	int RunInputEventTests(tWorld& world) {
+		int numFailed = 0;
+
+		// pressed and released within the first substep, polling once per frame would never see it
+		SetupInputEventRun(world);
+		QueueInput(0.001, INPUT_EVENT_JUMP, 1);
+		QueueInput(0.002, INPUT_EVENT_JUMP, 0);
+		Process(FRAME_TIME);
+		numFailed += !CheckInputEvents("tap inside one substep jumps", pmove->velocity[UP] > 0 && !nNumJumpPolls);
+
+		// exactly at the end of the frame belongs to the next one, anything before it to this one
+		// the last slice has to end at delta itself, not wherever the substeps added up to
+		SetupInputEventRun(world);
+		QueueInput(FRAME_TIME, INPUT_EVENT_JUMP, 1);
+		Process(FRAME_TIME);
+		bool carried = pmove->velocity[UP] <= 0;
+		Process(FRAME_TIME);
+		numFailed += !CheckInputEvents("event at the frame end carries over", carried && pmove->velocity[UP] > 0);
+
+		SetupInputEventRun(world);
+		QueueInput(std::nextafter(FRAME_TIME, 0.0), INPUT_EVENT_JUMP, 1);
+		Process(FRAME_TIME);
+		numFailed += !CheckInputEvents("event just before the frame end applies", pmove->velocity[UP] > 0);
+
+		// only jumps queued, everything else still comes from the callbacks
+		auto& script = *FindScript("duckjump");
+		std::vector<NyaVec3Double> origins;
+		SetupRun(world, script, false, false);
+		ClearInputEvents();
+		for (nFrame = 0; nFrame < 300; nFrame++) {
+			Process(FRAME_TIME);
+			origins.push_back(pmove->origin);
+		}
+		SetupRun(world, script, false, false);
+		int numMismatches = 0;
+		for (nFrame = 0; nFrame < 300; nFrame++) {
+			QueueInput(0, INPUT_EVENT_JUMP, script.jump());
+			Process(FRAME_TIME);
+			if (memcmp(&pmove->origin, &origins[nFrame], sizeof(pmove->origin))) numMismatches++;
+		}
+		numFailed += !CheckInputEvents("jump events only, the rest matches polling", !numMismatches);
+
+		// taps and view angle events recorded, then replayed from the log alone
+		auto path = (std::filesystem::temp_directory_path() / "FreemanAPI_bench_inputevents.rec").string();
+		SetupInputEventRun(world);
+		EXT_GetGamePlayerDead = NotDead;
+		bool recording = StartRecording(path.c_str());
+		for (nFrame = 0; nFrame < 300; nFrame++) {
+			if (nFrame % 45 == 0) {
+				QueueInput(0.005, INPUT_EVENT_JUMP, 1);
+				QueueInput(0.006, INPUT_EVENT_JUMP, 0);
+			}
+			FreemanInputEvent view = {};
+			view.time = FRAME_TIME * 0.5;
+			view.type = INPUT_EVENT_VIEWANGLES;
+			view.value[YAW] = nFrame * 0.7;
+			QueueInputEvent(view);
+			Process(FRAME_TIME);
+		}
+		StopRecording();
+		FreemanReplayResult result;
+		bool replayed = recording && ReplayRecording(path.c_str(), &result);
+		std::filesystem::remove(path);
+		EXT_GetGamePlayerDead = nullptr;
+		numFailed += !CheckInputEvents("recorded events replay without a desync", replayed && !result.desynced && !result.numOutputMismatches && result.numFrames == 300);
+
+		// back to polling, the jump callback gets asked once per frame again
+		ClearInputEvents();
+		nNumJumpPolls = 0;
+		Process(FRAME_TIME);
+		numFailed += !CheckInputEvents("ClearInputEvents goes back to polling", nNumJumpPolls == 1);
+
+		return numFailed;
+	}
+
+	// every context plays its own script, picked by its id
+	const tScript& GetContextScript() {
+		return aScripts[GetContextID() % std::size(aScripts)];
+	}
+	void ContextViewAngle(double* out) { GetContextScript().viewAngle(out); }
+	float ContextFwdBack() { return GetContextScript().fwdBack(); }
+	float ContextLeftRight() { return GetContextScript().leftRight(); }
+	float ContextUpDown() { return GetContextScript().upDown(); }
+	bool ContextJump() { return GetContextScript().jump(); }
+	bool ContextDuck() { return GetContextScript().duck(); }
+	bool ContextRun() { return GetContextScript().run(); }
+
+	// what getting into the host's collision costs on top of the trace itself, a scripting layer, a lock, a hop to another thread
+	double fCallbackCostMicros = 0;
+	void SpinCallbackCost() {
+		if (fCallbackCostMicros <= 0) return;
+		auto end = GetProfileMicros() + fCallbackCostMicros;
+		while (GetProfileMicros() < end) {}
+	}
+
+	pmtrace_t* CostedPlayerTrace(const double* start, const double* end) {
+		SpinCallbackCost();
+		return WorldPlayerTrace(start, end);
+	}
+
+	int nNumTraceBatches = 0;
+	int nNumBatchedTraces = 0;
+	void CountedPlayerTraceBatch(const FreemanHullTrace* traces, int count, pmtrace_t* out) {
+		SpinCallbackCost();
+		nNumTraceBatches++;
+		nNumBatchedTraces += count;
+		WorldPlayerTraceBatch(traces, count, out);
+	}
+
+	// the same players once with Process on each context in turn and once with StepContexts, frame by frame they have to match exactly
+	// the Process p50 leaves out the time a player spent parked, so it should come out about the same both ways
+	void RunLockstepBenchmark(tWorld& world, bool hl2, const std::vector<int>& ids, int numFrames) {
+		SetupRun(world, aScripts[0], hl2, false);
+		EXT_GetGamePlayerViewAngle = ContextViewAngle;
+		EXT_GetGameMoveFwdBack = ContextFwdBack;
+		EXT_GetGameMoveLeftRight = ContextLeftRight;
+		EXT_GetGameMoveUpDown = ContextUpDown;
+		EXT_GetGameMoveJump = ContextJump;
+		EXT_GetGameMoveDuck = ContextDuck;
+		EXT_GetGameMoveRun = ContextRun;
+		EXT_PM_PlayerTrace = CostedPlayerTrace;
+		EXT_PM_PlayerTraceBatch = CountedPlayerTraceBatch;
+
+		auto stateSize = GetStateSize();
+		std::vector<uint8_t> spawnStates(ids.size() * stateSize);
+		for (int i = 0; i < (int)ids.size(); i++) {
+			SetContext(ids[i]);
+			Reset();
+			SaveState(&spawnStates[i * stateSize]);
+			ResetStats();
+		}
+
+		std::vector<NyaVec3Double> origins(numFrames * ids.size());
+		FreemanLatencyStats sequentialLatency, lockstepLatency;
+		ResetLatencyStats();
+		double start = GetProfileMicros();
+		for (nFrame = 0; nFrame < numFrames; nFrame++) {
+			for (int i = 0; i < (int)ids.size(); i++) {
+				SetContext(ids[i]);
+				Process(FRAME_TIME);
+				origins[nFrame * ids.size() + i] = pmove->origin;
+			}
+		}
+		double sequentialMicros = GetProfileMicros() - start;
+		GetLatencyStats(&sequentialLatency);
+
+		uint64_t numTraceCalls = 0;
+		for (int i = 0; i < (int)ids.size(); i++) {
+			SetContext(ids[i]);
+			numTraceCalls += stats.numPlayerTraceCalls + stats.numPlayerTraceDownCalls;
+			LoadState(&spawnStates[i * stateSize], stateSize);
+		}
+
+		nNumTraceBatches = 0;
+		nNumBatchedTraces = 0;
+		int numMismatches = 0;
+		bLockstepBatching = true;
+		ResetLatencyStats();
+		start = GetProfileMicros();
+		for (nFrame = 0; nFrame < numFrames; nFrame++) {
+			StepContexts(ids.data(), ids.size(), FRAME_TIME);
+			for (int i = 0; i < (int)ids.size(); i++) {
+				if (memcmp(&aContexts[ids[i]]->move->origin, &origins[nFrame * ids.size() + i], sizeof(NyaVec3Double))) numMismatches++;
+			}
+		}
+		double lockstepMicros = GetProfileMicros() - start;
+		GetLatencyStats(&lockstepLatency);
+		bLockstepBatching = false;
+		SetContext(0);
+
+		printf("%-4s %-9s %10.1f %10.1f %10.1f %12.1f %12.1f %12.1f %12.1f %12d\n", hl2 ? "hl2" : "hl1", world.name, numTraceCalls / (double)numFrames, nNumTraceBatches / (double)numFrames,
+			   nNumBatchedTraces / (double)std::max(nNumTraceBatches, 1), sequentialMicros / numFrames, lockstepMicros / numFrames,
+			   sequentialLatency.process.p50, lockstepLatency.process.p50, numMismatches);
+	}
+
+	// what a FREEMANAPI_LATENCY_SCOPE costs, the two clock reads and the record on their own and together,
+	// and what a sampled scope like the trace callbacks use costs per call
+	// every thread records into the same histogram like the farm workers do, so the contended case shows up too
+	void RunLatencyBenchmark(int numThreads, int numSamples) {
+		static tLatencyHistogram histogram;
+		std::atomic<uint64_t> sink = 0;
+
+		auto measure = [&](auto&& body) {
+			histogram.Reset();
+			std::atomic<int> numReady = 0;
+			std::vector<std::thread> threads;
+			std::vector<double> aNanos(numThreads);
+			for (int t = 0; t < numThreads; t++) {
+				threads.emplace_back([&, t]() {
+					// start together so the threads are actually fighting over the cache lines
+					numReady++;
+					while (numReady < numThreads) {}
+					uint64_t sum = 0;
+					auto start = GetProfileNanos();
+					for (int i = 0; i < numSamples; i++) {
+						sum += body(i);
+					}
+					aNanos[t] = (GetProfileNanos() - start) / (double)numSamples;
+					sink += sum;
+				});
+			}
+			for (auto& thread : threads) {
+				thread.join();
+			}
+			double nanos = 0;
+			for (auto& value : aNanos) nanos += value;
+			return nanos / numThreads;
+		};
+
+		double loop = measure([](int i) { return (uint64_t)i; });
+		double clock = measure([](int) { return GetLatencyTicks() - GetLatencyTicks(); });
+		double record = measure([](int i) { histogram.Record(i & 1023); return (uint64_t)0; });
+		double scope = measure([](int i) { tLatencyScope scope(histogram); return (uint64_t)i; });
+		double sampled = measure([](int i) { tLatencyScope scope(histogram, i); return (uint64_t)i; });
+		printf("%7d %10.1f %10.1f %10.1f %10.1f\n", numThreads, clock - loop, record - loop, scope - loop, sampled - loop);
+	}
+}
+
+#include "bench_golden.h"
+
+int main(int argc, char** argv) {
+	using namespace FreemanBench;
+
+	if (argc > 1 && !strcmp(argv[1], "--rollback")) {
+		int numTicks = argc > 2 ? std::max(atoi(argv[2]), 1) : 10;
+		int budgetMicros = argc > 3 ? std::max(atoi(argv[3]), 0) : 0;
+		SetupHeadless();
+		auto worlds = CreateWorlds();
+		printf("%d tick rollbacks, %dus budget\n\n", numTicks, budgetMicros);
+		printf("%-4s %-9s %-11s %12s %12s\n", "mode", "world", "script", "us/rollback", "mismatches");
+		for (int hl2 = 0; hl2 < 2; hl2++) {
+			for (auto& world : worlds) {
+				for (auto& script : aScripts) {
+					RunRollbackBenchmark(world, script, hl2, 600, numTicks, budgetMicros);
+				}
+			}
+		}
+		return 0;
+	}
+	if (argc > 1 && !strcmp(argv[1], "--fallback")) {
+		SetupHeadless();
+		auto worlds = CreateWorlds();
+		printf("%-4s %-9s %-11s %12s %12s\n", "mode", "world", "script", "rays/f", "embedded");
+		int numEmbedded = 0;
+		for (int hl2 = 0; hl2 < 2; hl2++) {
+			for (auto& world : worlds) {
+				for (auto& script : aScripts) {
+					numEmbedded += RunFallbackCheck(world, script, hl2, 600);
+				}
+			}
+		}
+		printf("\n%d frames ended inside geometry\n", numEmbedded);
+		return numEmbedded ? 1 : 0;
+	}
+	if (argc > 1 && !strcmp(argv[1], "--netstate")) {
+		SetupHeadless();
+		auto worlds = CreateWorlds();
+		printf("%-9s %10s %10s %10s %12s\n", "baseline", "bytes/p", "encode ns", "decode ns", "mismatches");
+		RunNetStateBenchmark(worlds, 600);
+		return 0;
+	}
+	if (argc > 1 && !strcmp(argv[1], "--inputevents")) {
+		SetupHeadless();
+		auto worlds = CreateWorlds();
+		int numFailed = RunInputEventTests(*FindWorld(worlds, "flat"));
+		printf("\n%d failed\n", numFailed);
+		return numFailed ? 1 : 0;
+	}
+	if (argc > 1 && !strcmp(argv[1], "--latency")) {
+		int maxThreads = argc > 2 ? std::max(atoi(argv[2]), 1) : std::max((int)std::thread::hardware_concurrency(), 1);
+		printf("ns per sample, loop overhead taken out\n\n");
+		printf("%7s %10s %10s %10s %10s\n", "threads", "clock x2", "record", "scope", "sampled");
+		for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+			RunLatencyBenchmark(numThreads, 10000000);
+		}
+		return 0;
+	}
+	if (argc > 1 && !strcmp(argv[1], "--lockstep")) {
+		int numPlayers = argc > 2 ? std::max(atoi(argv[2]), 2) : 12;
+		fCallbackCostMicros = argc > 3 ? atof(argv[3]) : 0;
+		SetupHeadless();
+		auto worlds = CreateWorlds();
+		std::vector<int> ids = { 0 };
+		while ((int)ids.size() < numPlayers) {
+			ids.push_back(CreateContext());
+		}
+		printf("%d players, one script each, hull traces sent one at a time vs batched by StepContexts, %.1f us per host call\n\n", numPlayers, fCallbackCostMicros);
+		printf("%-4s %-9s %10s %10s %10s %12s %12s %12s %12s %12s\n", "mode", "world", "traces/f", "batches/f", "avg batch", "us/f turns", "us/f lock", "p50 turns", "p50 lock", "mismatches");
+		for (int hl2 = 0; hl2 < 2; hl2++) {
+			for (auto& world : worlds) {
+				RunLockstepBenchmark(world, hl2, ids, 600);
+			}
+		}
+		return 0;
+	}
+	if (argc > 1 && (!strcmp(argv[1], "--golden") || !strcmp(argv[1], "--update-golden"))) {
+		return RunGoldenSuite(argc > 2 ? argv[2] : GetDefaultGoldenDir().c_str(), !strcmp(argv[1], "--update-golden"));
+	}
+
+	int numFrames = argc > 1 ? std::max(atoi(argv[1]), 1) : 3600;
+	const char* worldFilter = argc > 2 ? argv[2] : nullptr;
+	const char* scriptFilter = argc > 3 ? argv[3] : nullptr;
+
+	SetupHeadless();
+	auto worlds = CreateWorlds();
+
+	printf("%d frames per run at %.0f fps, %d physics steps\n\n", numFrames, 1.0 / FRAME_TIME, nPhysicsSteps);
+	printf("%-4s %-9s %-9s %-11s %12s %10s %10s %12s %12s\n", "mode", "collision", "world", "script", "ns/substep", "p50 ns", "p99 ns", "callbacks/f", "allocs/f");
+	for (int hl2 = 0; hl2 < 2; hl2++) {
+		for (int collision = 0; collision < NUM_COLLISION_MODES; collision++) {
+			for (auto& world : worlds) {
+				if (worldFilter && strcmp(worldFilter, world.name)) continue;
+
+				for (auto& script : aScripts) {
+					if (scriptFilter && strcmp(scriptFilter, script.name)) continue;
+
+					auto result = RunBenchmark(world, script, hl2, collision, numFrames);
+					printf("%-4s %-9s %-9s %-11s %12.1f %10.0f %10.0f %12.1f %12.1f\n", hl2 ? "hl2" : "hl1", aCollisionModeNames[collision], world.name, script.name,
+						   result.nsPerSubstep, result.p50, result.p99, result.callbacksPerFrame, result.allocsPerFrame);
+				}
+			}
+		}
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,245 @@
+// golden trajectory suite
+// canonical scenarios for the movement feel we care about, checked against trajectories stored from a trusted build
+// the references in tools/golden are from the tree the suite was added in, they come out the same at -O0, -O2 and -O3
+// they depend on nya-common's NyaMat4x4 (../nya-common, FREEMANAPI_NYA_COMMON_DIR in cmake) building the hl1 mathlib basis,
+// RunGoldenSuite checks that before comparing anything
+// hl1_ramps was rewritten when the bench ramps got the top bevel the player used to catch on
+// --golden compares against them, --update-golden rewrites them, only do that for a deliberate change in movement feel
+namespace FreemanBench {
+	struct tScenario {
+		const char* name;
+		const char* world;
+		const char* script;
+		bool hl2;
+		bool autoHop;
+		bool bhopCap;
+		bool abh;
+		int numFrames;
+	};
+
+	const tScenario aScenarios[] = {
+		{ "hl1_bhop", "flat", "strafejump", false, true, false, false, 900 },
+		{ "hl1_bhop_capped", "flat", "strafejump", false, true, true, false, 900 }, // PM_PreventMegaBunnyJumping
+		{ "hl2_bhop", "flat", "strafejump", true, true, false, false, 900 },
+		{ "hl2_abh", "flat", "backhop", true, true, false, true, 600 },
+		{ "hl1_jump", "flat", "jump", false, false, false, false, 180 },
+		{ "hl2_jump", "flat", "jump", true, false, false, false, 180 }, // GAMEMOVEMENT_JUMP_HEIGHT
+		{ "hl1_duckjump", "flat", "duckjump", false, false, false, false, 240 },
+		{ "hl2_duckjump", "flat", "duckjump", true, false, false, false, 240 },
+		{ "hl1_stairs", "stairs", "climb", false, false, false, false, 600 }, // "run" holds the walk key in HL1
+		{ "hl2_stairs", "stairs", "run", true, false, false, false, 600 },
+		{ "hl1_ramps", "ramps", "strafejump", false, true, false, false, 600 },
+		{ "hl2_corridor", "corridor", "duckjump", true, false, false, false, 600 },
+		{ "hl1_swim", "pool", "swim", false, false, false, false, 600 },
+		{ "hl2_swim", "pool", "swim", true, false, false, false, 600 },
+	};
+
+	// one sample per frame, compared field by field
+	struct tGoldenSample {
+		NyaVec3Double origin;
+		NyaVec3Double velocity;
+		int onGround;
+		int ducked;
+	};
+
+	// how far a sample may drift from the reference before it counts as a regression
+	// loose enough for reordered float math, tight enough to catch a changed speed cap or jump height
+	const double GOLDEN_ORIGIN_TOLERANCE = 0.1; // units
+	const double GOLDEN_VELOCITY_TOLERANCE = 0.5; // units per second
+
+	// spawnZ is where the player was put before the first frame, the first sample already has a frame of movement in it
+	std::vector<tGoldenSample> RunScenario(std::vector<tWorld>& worlds, const tScenario& scenario, double& spawnZ) {
+		std::vector<tGoldenSample> samples;
+
+		auto world = FindWorld(worlds, scenario.world);
+		auto script = FindScript(scenario.script);
+		if (!world || !script) return samples;
+
+		bAutoHop = scenario.autoHop;
+		bBhopCap = scenario.bhopCap;
+		bABH = scenario.abh;
+		bABHMixed = false;
+		SetupRun(*world, *script, scenario.hl2, false);
+		spawnZ = pmove->origin[UP];
+
+		for (nFrame = 0; nFrame < scenario.numFrames; nFrame++) {
+			Process(FRAME_TIME);
+
+			tGoldenSample sample;
+			sample.origin = pmove->origin;
+			sample.velocity = pmove->velocity;
+			sample.onGround = pmove->onground != -1;
+			sample.ducked = (pmove->flags & FL_DUCKING) != 0;
+			samples.push_back(sample);
+		}
+		return samples;
+	}
+
+	// the checked in references next to this file, __FILE__ is relative to where it was built from so the repo root and tools are tried too
+	std::string GetDefaultGoldenDir() {
+		std::filesystem::path aDirs[] = {
+			std::filesystem::path(__FILE__).parent_path() / "golden",
+			"tools/golden",
+			"golden",
+		};
+		for (auto& dir : aDirs) {
+			if (std::filesystem::is_directory(dir)) return dir.string();
+		}
+		return aDirs[0].string();
+	}
+
+	std::filesystem::path GetGoldenPath(const char* dir, const tScenario& scenario) {
+		return std::filesystem::path(dir) / (std::string(scenario.name) + ".txt");
+	}
+
+	bool WriteGolden(const std::filesystem::path& path, const std::vector<tGoldenSample>& samples) {
+		auto file = fopen(path.string().c_str(), "w");
+		if (!file) return false;
+		for (auto& sample : samples) {
+			fprintf(file, "%.17g %.17g %.17g %.17g %.17g %.17g %d %d\n", sample.origin.x, sample.origin.y, sample.origin.z, sample.velocity.x, sample.velocity.y, sample.velocity.z, sample.onGround, sample.ducked);
+		}
+		fclose(file);
+		return true;
+	}
+
+	bool ReadGolden(const std::filesystem::path& path, std::vector<tGoldenSample>& samples) {
+		auto file = fopen(path.string().c_str(), "r");
+		if (!file) return false;
+		tGoldenSample sample;
+		while (fscanf(file, "%lf %lf %lf %lf %lf %lf %d %d", &sample.origin.x, &sample.origin.y, &sample.origin.z, &sample.velocity.x, &sample.velocity.y, &sample.velocity.z, &sample.onGround, &sample.ducked) == 8) {
+			samples.push_back(sample);
+		}
+		fclose(file);
+		return true;
+	}
+
+	// returns the first frame that's out of tolerance, or -1
+	int CompareGolden(const std::vector<tGoldenSample>& samples, const std::vector<tGoldenSample>& golden, std::string& reason) {
+		if (samples.size() != golden.size()) {
+			reason = std::to_string(samples.size()) + " frames, reference has " + std::to_string(golden.size());
+			return std::min(samples.size(), golden.size());
+		}
+
+		for (int i = 0; i < (int)samples.size(); i++) {
+			auto& a = samples[i];
+			auto& b = golden[i];
+			char tmp[256];
+			if ((a.origin - b.origin).length() > GOLDEN_ORIGIN_TOLERANCE) {
+				snprintf(tmp, sizeof(tmp), "origin %.3f %.3f %.3f, reference %.3f %.3f %.3f", a.origin.x, a.origin.y, a.origin.z, b.origin.x, b.origin.y, b.origin.z);
+			}
+			else if ((a.velocity - b.velocity).length() > GOLDEN_VELOCITY_TOLERANCE) {
+				snprintf(tmp, sizeof(tmp), "velocity %.3f %.3f %.3f, reference %.3f %.3f %.3f", a.velocity.x, a.velocity.y, a.velocity.z, b.velocity.x, b.velocity.y, b.velocity.z);
+			}
+			else if (a.onGround != b.onGround) {
+				snprintf(tmp, sizeof(tmp), "onground %d, reference %d", a.onGround, b.onGround);
+			}
+			else if (a.ducked != b.ducked) {
+				snprintf(tmp, sizeof(tmp), "ducked %d, reference %d", a.ducked, b.ducked);
+			}
+			else continue;
+
+			reason = tmp;
+			return i;
+		}
+		return -1;
+	}
+
+	// the numbers people actually talk about, printed so a reviewer can eyeball a golden update
+	void PrintScenarioSummary(const tScenario& scenario, const std::vector<tGoldenSample>& samples, double spawnZ) {
+		double peakZ = spawnZ;
+		double maxSpeed = 0;
+		for (auto& sample : samples) {
+			peakZ = std::max(peakZ, sample.origin.z);
+			maxSpeed = std::max(maxSpeed, std::sqrt(sample.velocity.x * sample.velocity.x + sample.velocity.y * sample.velocity.y));
+		}
+		printf("%-16s peak height %7.2f, max ground speed %8.2f", scenario.name, peakZ - spawnZ, maxSpeed);
+	}
+
+	// the references only mean anything if nya-common's NyaMat4x4::Rotate gives AngleVectors the same basis as hl1's mathlib
+	// checked against the mathlib formulas first so a different nya-common fails here and not as 14 unexplained trajectories
+	bool CheckAngleVectorsBasis() {
+		const double aAngles[][2] = { { 0, 0 }, { 0, 90 }, { 30, 45 }, { -60, 200 }, { 89, -135 } };
+		for (auto& pitchYaw : aAngles) {
+			NyaVec3Double angles = {0, 0, 0};
+			angles[PITCH] = pitchYaw[0];
+			angles[YAW] = pitchYaw[1];
+			NyaVec3Double fwd, right, up;
+			AngleVectors(angles, fwd, right, up);
+
+			double sp = std::sin(pitchYaw[0] * std::numbers::pi / 180.0);
+			double cp = std::cos(pitchYaw[0] * std::numbers::pi / 180.0);
+			double sy = std::sin(pitchYaw[1] * std::numbers::pi / 180.0);
+			double cy = std::cos(pitchYaw[1] * std::numbers::pi / 180.0);
+			NyaVec3Double hlFwd = {cp * cy, cp * sy, -sp};
+			NyaVec3Double hlUp = {sp * cy, sp * sy, cp};
+			if ((fwd - hlFwd).length() > 0.001 || (up - hlUp).length() > 0.001) {
+				printf("AngleVectors basis differs from hl1 at pitch %.0f yaw %.0f: forward %.3f %.3f %.3f, expected %.3f %.3f %.3f\n",
+					   pitchYaw[0], pitchYaw[1], fwd.x, fwd.y, fwd.z, hlFwd.x, hlFwd.y, hlFwd.z);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int RunGoldenSuite(const char* dir, bool update) {
+		SetupHeadless();
+		if (!CheckAngleVectorsBasis()) {
+			printf("the golden references need the nya-common math they were generated with, see the top of bench_golden.h\n");
+			return 1;
+		}
+		auto worlds = CreateWorlds();
+
+		bool savedAutoHop = bAutoHop;
+		bool savedBhopCap = bBhopCap;
+		bool savedABH = bABH;
+		bool savedABHMixed = bABHMixed;
+
+		if (update) std::filesystem::create_directories(dir);
+
+		int numFailed = 0;
+		for (auto& scenario : aScenarios) {
+			double spawnZ = 0;
+			auto samples = RunScenario(worlds, scenario, spawnZ);
+			auto path = GetGoldenPath(dir, scenario);
+			PrintScenarioSummary(scenario, samples, spawnZ);
+
+			if (samples.empty()) {
+				printf(" FAILED, unknown world or script\n");
+				numFailed++;
+				continue;
+			}
+
+			if (update) {
+				bool ok = WriteGolden(path, samples);
+				printf(ok ? " written\n" : " FAILED to write %s\n", path.string().c_str());
+				if (!ok) numFailed++;
+				continue;
+			}
+
+			std::vector<tGoldenSample> golden;
+			if (!ReadGolden(path, golden)) {
+				printf(" FAILED, no reference at %s\n", path.string().c_str());
+				numFailed++;
+				continue;
+			}
+
+			std::string reason;
+			int frame = CompareGolden(samples, golden, reason);
+			if (frame < 0) {
+				printf(" ok\n");
+			}
+			else {
+				printf(" FAILED at frame %d: %s\n", frame, reason.c_str());
+				numFailed++;
+			}
+		}
+
+		bAutoHop = savedAutoHop;
+		bBhopCap = savedBhopCap;
+		bABH = savedABH;
+		bABHMixed = savedABHMixed;
+
+		printf("\n%d/%d scenarios %s\n", (int)std::size(aScenarios) - numFailed, (int)std::size(aScenarios), update ? "written" : "passed");
+		return numFailed ? 1 : 0;
+	}
+}
\ No newline at end of file
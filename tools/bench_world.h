@@ -0,0 +1,307 @@
+// procedurally generated collision worlds for the headless tools
+// worlds are made of convex brushes like a quake map, traces are swept AABB vs brush clips
+// everything is in HL units, z-up
+namespace FreemanBench {
+	using namespace FreemanAPI;
+
+	const double TRACE_EPSILON = 0.03125; // 1/32, same as the quake engines
+
+	struct tPlane {
+		NyaVec3Double normal;
+		double dist;
+	};
+
+	struct tBrush {
+		std::vector<tPlane> planes;
+		NyaVec3Double mins, maxs; // bounds, for early outs
+		int contents = -1; // -1 for solid, otherwise a CONTENTS_ value for liquids
+	};
+
+	struct tWorld {
+		const char* name;
+		std::vector<tBrush> brushes;
+		NyaVec3Double spawn; // player center
+	};
+
+	tWorld* pWorld = nullptr;
+
+	void AddBox(tWorld& world, NyaVec3Double mins, NyaVec3Double maxs, int contents = -1) {
+		tBrush brush;
+		brush.planes = {
+			{{ 1, 0, 0}, maxs.x}, {{-1, 0, 0}, -mins.x},
+			{{ 0, 1, 0}, maxs.y}, {{ 0,-1, 0}, -mins.y},
+			{{ 0, 0, 1}, maxs.z}, {{ 0, 0,-1}, -mins.z},
+		};
+		brush.mins = mins;
+		brush.maxs = maxs;
+		brush.contents = contents;
+		world.brushes.push_back(brush);
+	}
+
+	// wedge rising along +x from mins.x to maxs.x
+	// the top plane doesn't cut anything off the wedge, it's the axial bevel that keeps a box clipped against it from catching on the top edge
+	void AddRamp(tWorld& world, NyaVec3Double mins, NyaVec3Double maxs) {
+		auto run = maxs.x - mins.x;
+		auto rise = maxs.z - mins.z;
+		auto len = std::sqrt(run * run + rise * rise);
+		NyaVec3Double slope = { -rise / len, 0, run / len };
+
+		tBrush brush;
+		brush.planes = {
+			{{ 1, 0, 0}, maxs.x}, {{-1, 0, 0}, -mins.x},
+			{{ 0, 1, 0}, maxs.y}, {{ 0,-1, 0}, -mins.y},
+			{{ 0, 0, 1}, maxs.z}, {{ 0, 0,-1}, -mins.z},
+			{slope, slope.x * mins.x + slope.z * mins.z},
+		};
+		brush.mins = mins;
+		brush.maxs = maxs;
+		world.brushes.push_back(brush);
+	}
+
+	void AddStairs(tWorld& world, NyaVec3Double start, int numSteps, double stepDepth, double stepHeight, double width) {
+		for (int i = 0; i < numSteps; i++) {
+			auto x = start.x + i * stepDepth;
+			AddBox(world, {x, start.y - width * 0.5, start.z}, {x + stepDepth, start.y + width * 0.5, start.z + (i + 1) * stepHeight});
+		}
+	}
+
+	void AddFloor(tWorld& world, double size) {
+		AddBox(world, {-size, -size, -64}, {size, size, 0});
+	}
+
+	// clips a box moving from start to end against one brush, quake 3 style
+	void ClipBoxToBrush(const tBrush& brush, const NyaVec3Double& start, const NyaVec3Double& end, const NyaVec3Double& mins, const NyaVec3Double& maxs, pmtrace_t& trace, int ent) {
+		double enterFrac = -1;
+		double leaveFrac = 1;
+		const tPlane* clipPlane = nullptr;
+		bool startOut = false;
+		bool getOut = false;
+
+		for (auto& plane : brush.planes) {
+			// push the plane out by the box extents
+			NyaVec3Double offset;
+			for (int i = 0; i < 3; i++) {
+				offset[i] = plane.normal[i] < 0 ? maxs[i] : mins[i];
+			}
+			auto dist = plane.dist - DotProduct(offset, plane.normal);
+
+			auto d1 = DotProduct(start, plane.normal) - dist;
+			auto d2 = DotProduct(end, plane.normal) - dist;
+
+			if (d2 > 0) getOut = true;
+			if (d1 > 0) startOut = true;
+
+			// completely in front of this plane, can't hit the brush
+			if (d1 > 0 && (d2 >= TRACE_EPSILON || d2 >= d1)) return;
+			// completely behind, another plane will clip it
+			if (d1 <= 0 && d2 <= 0) continue;
+
+			if (d1 > d2) {
+				auto f = (d1 - TRACE_EPSILON) / (d1 - d2);
+				if (f > enterFrac) {
+					enterFrac = f;
+					clipPlane = &plane;
+				}
+			}
+			else {
+				auto f = (d1 + TRACE_EPSILON) / (d1 - d2);
+				if (f < leaveFrac) leaveFrac = f;
+			}
+		}
+
+		if (!startOut) {
+			trace.startsolid = true;
+			trace.ent = ent;
+			if (!getOut) {
+				trace.allsolid = true;
+				trace.fraction = 0;
+			}
+			return;
+		}
+
+		if (clipPlane && enterFrac < leaveFrac && enterFrac > -1 && enterFrac < trace.fraction) {
+			trace.fraction = std::max(enterFrac, 0.0);
+			trace.plane.normal = clipPlane->normal;
+			trace.plane.dist = clipPlane->dist;
+			trace.ent = ent;
+		}
+	}
+
+	pmtrace_t* TraceBox(const double* _start, const double* _end, NyaVec3Double mins, NyaVec3Double maxs) {
+		static pmtrace_t trace;
+		trace.Default();
+
+		NyaVec3Double start = { _start[0], _start[1], _start[2] };
+		NyaVec3Double end = { _end[0], _end[1], _end[2] };
+
+		NyaVec3Double moveMins, moveMaxs;
+		for (int i = 0; i < 3; i++) {
+			moveMins[i] = std::min(start[i], end[i]) + mins[i] - 1;
+			moveMaxs[i] = std::max(start[i], end[i]) + maxs[i] + 1;
+		}
+
+		for (int i = 0; i < (int)pWorld->brushes.size(); i++) {
+			auto& brush = pWorld->brushes[i];
+			if (brush.contents != -1) continue;
+			if (brush.mins.x > moveMaxs.x || brush.mins.y > moveMaxs.y || brush.mins.z > moveMaxs.z) continue;
+			if (brush.maxs.x < moveMins.x || brush.maxs.y < moveMins.y || brush.maxs.z < moveMins.z) continue;
+
+			ClipBoxToBrush(brush, start, end, mins, maxs, trace, i);
+			if (trace.allsolid) break;
+		}
+
+		trace.endpos = start + (end - start) * trace.fraction;
+		trace.inopen = !trace.startsolid;
+		return &trace;
+	}
+
+	pmtrace_t* WorldPlayerTrace(const double* start, const double* end) {
+		auto hull = GetPlayerHullID();
+		return TraceBox(start, end, pmove->player_mins[hull], pmove->player_maxs[hull]);
+	}
+
+	pmtrace_t* WorldPointRaytrace(const double* start, const double* end) {
+		return TraceBox(start, end, {0,0,0}, {0,0,0});
+	}
+
+	// drops the hull onto the destination from above, whatever it lands on is what's in the way
+	// looks a unit further than the destination, a player pressed up against a wall only asks to move a tiny bit into it
+	float WorldStepHeight(const double* origin, const double* dest) {
+		const double probeHeight = 64;
+		NyaVec3Double dir = { dest[0] - origin[0], dest[1] - origin[1], 0 };
+		if (dir.length() < 0.001) return STEP_HEIGHT_UNKNOWN;
+		VectorNormalize(dir);
+
+		NyaVec3Double end = { dest[0] + dir.x, dest[1] + dir.y, dest[2] };
+		NyaVec3Double start = end;
+		start.z += probeHeight;
+		auto trace = WorldPlayerTrace(&start.x, &end.x);
+		if (trace->startsolid) return STEP_HEIGHT_UNKNOWN; // something overhangs the probe, can't tell
+		return trace->endpos[2] - origin[2];
+	}
+
+	void WorldPointRaytraceBatch(const double* starts, const double* ends, int count, pmtrace_t* out) {
+		for (int i = 0; i < count; i++) {
+			out[i] = *TraceBox(&starts[i * 3], &ends[i * 3], {0,0,0}, {0,0,0});
+		}
+	}
+
+	// every trace brings its own box, the players in a batch can be ducked or standing
+	void WorldPlayerTraceBatch(const FreemanHullTrace* traces, int count, pmtrace_t* out) {
+		for (int i = 0; i < count; i++) {
+			auto& trace = traces[i];
+			NyaVec3Double mins = { trace.mins[0], trace.mins[1], trace.mins[2] };
+			NyaVec3Double maxs = { trace.maxs[0], trace.maxs[1], trace.maxs[2] };
+			out[i] = *TraceBox(trace.start, trace.end, mins, maxs);
+		}
+	}
+
+	int WorldPointContents(const double* _point) {
+		NyaVec3Double point = { _point[0], _point[1], _point[2] };
+		for (auto& brush : pWorld->brushes) {
+			if (brush.contents == -1) continue;
+
+			bool inside = true;
+			for (auto& plane : brush.planes) {
+				if (DotProduct(point, plane.normal) > plane.dist) {
+					inside = false;
+					break;
+				}
+			}
+			if (inside) return brush.contents;
+		}
+		return CONTENTS_EMPTY;
+	}
+
+	// liquids in the test worlds are all boxes, the surface is the top of the one the point is in
+	double WorldWaterSurfaceHeight(const double* point, int* contents) {
+		*contents = WorldPointContents(point);
+		if (*contents == CONTENTS_EMPTY) return 0;
+		for (auto& brush : pWorld->brushes) {
+			if (brush.contents != *contents) continue;
+			if (point[0] < brush.mins.x || point[0] > brush.maxs.x) continue;
+			if (point[1] < brush.mins.y || point[1] > brush.maxs.y) continue;
+			if (point[2] < brush.mins.z || point[2] > brush.maxs.z) continue;
+			return brush.maxs.z;
+		}
+		return 0;
+	}
+
+	std::vector<tWorld> CreateWorlds() {
+		std::vector<tWorld> worlds;
+
+		{
+			tWorld world = { "flat", {}, {} };
+			AddFloor(world, 8192);
+			world.spawn = {0, 0, 37};
+			worlds.push_back(world);
+		}
+
+		{
+			tWorld world = { "stairs", {}, {} };
+			AddFloor(world, 8192);
+			AddStairs(world, {64, 0, 0}, 40, 32, 16, 512);
+			AddStairs(world, {64 + 40 * 32, 300, 0}, 40, 12, 8, 256); // shallow steps, lots of small step ups
+			world.spawn = {0, 0, 37};
+			worlds.push_back(world);
+		}
+
+		{
+			tWorld world = { "ramps", {}, {} };
+			AddFloor(world, 8192);
+			for (int i = 0; i < 8; i++) {
+				auto x = 128.0 + i * 512;
+				AddRamp(world, {x, -256, 0}, {x + 256, 256, 256});
+				AddBox(world, {x + 256, -256, 0}, {x + 384, 256, 256});
+			}
+			world.spawn = {0, 0, 37};
+			worlds.push_back(world);
+		}
+
+		{
+			tWorld world = { "corridor", {}, {} };
+			AddFloor(world, 8192);
+			// a zigzagging corridor just wider than the player, with a low section that needs ducking
+			for (int i = 0; i < 16; i++) {
+				auto x = i * 256.0;
+				auto y = (i % 2) * 8.0;
+				AddBox(world, {x, y + 20, 0}, {x + 256, y + 84, 128});
+				AddBox(world, {x, y - 84, 0}, {x + 256, y - 20, 128});
+				AddBox(world, {x, y - 20, (i % 4 == 3) ? 48.0 : 96.0}, {x + 256, y + 20, 128});
+			}
+			world.spawn = {-64, 0, 37};
+			worlds.push_back(world);
+		}
+
+		{
+			tWorld world = { "pool", {}, {} };
+			AddBox(world, {-8192, -8192, -64}, {8192, -512, 0});
+			AddBox(world, {-8192, 512, -64}, {8192, 8192, 0});
+			AddBox(world, {-8192, -512, -64}, {-512, 512, 0});
+			AddBox(world, {512, -512, -64}, {8192, 512, 0});
+			AddBox(world, {-512, -512, -320}, {512, 512, -256}); // pool bottom
+			AddBox(world, {-512, -512, -256}, {512, 512, -8}, CONTENTS_WATER);
+			world.spawn = {0, 0, 37};
+			worlds.push_back(world);
+		}
+
+		{
+			tWorld world = { "arena", {}, {} };
+			AddFloor(world, 8192);
+			AddStairs(world, {128, -128, 0}, 12, 32, 16, 256);
+			AddRamp(world, {-640, -256, 0}, {-384, 256, 256});
+			AddBox(world, {-384, -256, 0}, {-128, 256, 256});
+			for (int i = 0; i < 24; i++) {
+				auto angle = i * (std::numbers::pi * 2 / 24);
+				auto x = std::cos(angle) * 900;
+				auto y = std::sin(angle) * 900;
+				AddBox(world, {x - 24, y - 24, 0}, {x + 24, y + 24, 24.0 + (i % 6) * 24}); // crates of varying heights
+			}
+			AddBox(world, {-256, 600, 0}, {256, 1000, 40}, CONTENTS_WATER); // wading depth
+			world.spawn = {0, 0, 37};
+			worlds.push_back(world);
+		}
+
+		return worlds;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+// replay farm
+// re-simulates a whole corpus of recorded sessions across every core and reports the ones that don't match their recording
+// every worker thread has its own player, settings and callbacks, see FREEMANAPI_THREAD_CONTEXTS
+// NyaMat4x4::bZUp lives in nya-common and is still shared, so a corpus has to be all y-up or all z-up
+// it is set once here before the workers start, -z for a z-up corpus, sessions recorded the other way show up as desynced
+// usage: FreemanAPI_replay_farm [-j threads] [-z] <recording or directory>...
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <format>
+#include <filesystem>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include "toml++/toml.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "nya_commonmath.h"
+
+#include "hlmov.h"
+
+namespace FreemanFarm {
+	using namespace FreemanAPI;
+
+	// read-only mapping of a whole file, the replay reads straight out of it
+	struct tMappedFile {
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+
+		bool Open(const std::filesystem::path& path) {
+#ifdef _WIN32
+			file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) return false;
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || !fileSize.QuadPart) return false;
+			size = fileSize.QuadPart;
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping) return false;
+			data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			return data != nullptr;
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) return false;
+			struct stat st;
+			if (fstat(fd, &st) || !st.st_size) {
+				close(fd);
+				return false;
+			}
+			size = st.st_size;
+			auto ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (ptr == MAP_FAILED) return false;
+			madvise(ptr, size, MADV_SEQUENTIAL);
+			data = (const uint8_t*)ptr;
+			return true;
+#endif
+		}
+
+		~tMappedFile() {
+#ifdef _WIN32
+			if (data) UnmapViewOfFile(data);
+			if (mapping) CloseHandle(mapping);
+			if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+			if (data) munmap((void*)data, size);
+#endif
+		}
+	};
+
+	struct tSession {
+		std::filesystem::path path;
+		uintmax_t fileSize = 0;
+		bool bOpened = false;
+		bool bRecording = false;
+		FreemanReplayResult result;
+
+		bool IsDivergent() const {
+			return !bRecording || result.desynced || result.numOutputMismatches;
+		}
+	};
+
+	std::vector<tSession> aSessions;
+
+	// work stealing pool, each worker drains its own queue from the back and steals from the front of the others
+	// sessions vary a lot in length, so this keeps every core busy until the very end
+	struct tWorkQueue {
+		std::mutex mutex;
+		std::deque<size_t> items;
+
+		bool PopBack(size_t& out) {
+			std::lock_guard lock(mutex);
+			if (items.empty()) return false;
+			out = items.back();
+			items.pop_back();
+			return true;
+		}
+
+		bool PopFront(size_t& out) {
+			std::lock_guard lock(mutex);
+			if (items.empty()) return false;
+			out = items.front();
+			items.pop_front();
+			return true;
+		}
+	};
+
+	std::vector<tWorkQueue> aQueues;
+
+	bool GetWork(int worker, size_t& out) {
+		if (aQueues[worker].PopBack(out)) return true;
+		for (int i = 1; i < (int)aQueues.size(); i++) {
+			if (aQueues[(worker + i) % aQueues.size()].PopFront(out)) return true;
+		}
+		return false;
+	}
+
+	void ReplaySession(tSession& session) {
+		tMappedFile file;
+		if (!file.Open(session.path)) return;
+		session.bOpened = true;
+		// a failed replay that didn't desync never got past the header
+		session.bRecording = ReplayRecording(file.data, file.size, &session.result) || session.result.desynced;
+	}
+
+	void WorkerThread(int worker) {
+		size_t index;
+		while (GetWork(worker, index)) {
+			ReplaySession(aSessions[index]);
+		}
+	}
+
+	void AddPath(const std::filesystem::path& path) {
+		std::error_code error;
+		if (std::filesystem::is_directory(path, error)) {
+			for (auto& entry : std::filesystem::recursive_directory_iterator(path, error)) {
+				if (!entry.is_regular_file()) continue;
+				aSessions.push_back({entry.path(), entry.file_size(), false, false, {}});
+			}
+			return;
+		}
+		aSessions.push_back({path, std::filesystem::file_size(path, error), false, false, {}});
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace FreemanFarm;
+
+	int numThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			numThreads = std::max(atoi(argv[++i]), 1);
+			continue;
+		}
+		if (!strcmp(argv[i], "-z")) {
+			NyaMat4x4::bZUp = true;
+			continue;
+		}
+		AddPath(argv[i]);
+	}
+	if (aSessions.empty()) {
+		printf("usage: %s [-j threads] [-z] <recording or directory>...\n", argv[0]);
+		return 2;
+	}
+
+	// deal the biggest sessions out first so the long tail is made of short ones
+	std::vector<size_t> order(aSessions.size());
+	for (size_t i = 0; i < order.size(); i++) order[i] = i;
+	std::sort(order.begin(), order.end(), [](size_t a, size_t b) { return aSessions[a].fileSize > aSessions[b].fileSize; });
+
+	numThreads = std::min<int>(numThreads, aSessions.size());
+	aQueues = std::vector<tWorkQueue>(numThreads);
+	for (size_t i = 0; i < order.size(); i++) {
+		aQueues[i % numThreads].items.push_front(order[i]);
+	}
+
+	printf("replaying %d sessions on %d threads\n", (int)aSessions.size(), numThreads);
+
+	double start = GetProfileMicros();
+	std::vector<std::thread> threads;
+	for (int i = 0; i < numThreads; i++) {
+		threads.emplace_back(WorkerThread, i);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	double wallSeconds = (GetProfileMicros() - start) / 1000000.0;
+
+	uint64_t numFrames = 0;
+	double simulatedSeconds = 0;
+	int numDivergent = 0;
+	for (auto& session : aSessions) {
+		numFrames += session.result.numFrames;
+		simulatedSeconds += session.result.simulatedSeconds;
+		if (session.IsDivergent()) numDivergent++;
+	}
+
+	if (numDivergent) {
+		printf("\ndivergent sessions:\n");
+		for (auto& session : aSessions) {
+			if (!session.IsDivergent()) continue;
+
+			auto path = session.path.string();
+			auto& result = session.result;
+			if (!session.bOpened) {
+				printf("  %s: failed to open\n", path.c_str());
+			}
+			else if (!session.bRecording) {
+				printf("  %s: not a recording\n", path.c_str());
+			}
+			else if (result.numOutputMismatches) {
+				printf("  %s: %u/%u frames mismatched, first at frame %d%s\n", path.c_str(), result.numOutputMismatches, result.numFrames, result.firstOutputMismatch, result.desynced ? ", desynced" : "");
+			}
+			else {
+				printf("  %s: desynced after %u frames\n", path.c_str(), result.numFrames);
+			}
+		}
+	}
+
+	printf("\n%d/%d sessions matched\n", (int)aSessions.size() - numDivergent, (int)aSessions.size());
+	printf("%llu frames, %.1f simulated seconds in %.2f wall seconds\n", (unsigned long long)numFrames, simulatedSeconds, wallSeconds);
+	printf("%.0f frames/s, %.1f simulated seconds per wall second\n", numFrames / wallSeconds, simulatedSeconds / wallSeconds);
+	return numDivergent ? 1 : 0;
+}
\ No newline at end of file